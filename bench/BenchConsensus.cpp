@@ -0,0 +1,241 @@
+// End-to-end consensus benchmark: N validators on the in-process network commit a fixed number of
+// heights under a Poisson transaction load. Prints one JSON object on stdout; logs go to stderr.
+//
+//   bench_consensus [--validators N] [--heights H] [--rate TX_PER_S] [--seed S] [--delay MS]
+//                   [--drop RATE] [--threads] [--pipeline] [--metrics PATH]
+//
+// Arrivals, drops and delays come from the seed and the rate is in network time, so a run in the
+// default single-threaded simulated mode commits the same blocks every time. Only wall-clock
+// figures vary between runs. Nodes have no block sync, so with --drop a node that misses a
+// decision can stall later heights; "blocks" then falls short of "heights".
+
+#include "Node.h"
+#include "Network.h"
+#include "StateMachine.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Options {
+    int validators = 4;
+    int heights = 100;
+    double rate = 1000.0; // Transactions per second of network time
+    uint32_t seed = 42;
+    int delayMs = 50;
+    double dropRate = 0.0;
+    bool threads = false;
+    bool pipeline = false;
+    std::string metricsPath; // Prometheus text of the run, skipped when empty
+};
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--validators N] [--heights H] [--rate TX_PER_S] [--seed S]"
+              << " [--delay MS] [--drop RATE] [--threads] [--pipeline] [--metrics PATH]\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--threads") {
+            options.threads = true;
+            continue;
+        }
+        if (flag == "--pipeline") {
+            options.pipeline = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        try {
+            if (flag == "--validators") {
+                options.validators = std::stoi(value);
+            } else if (flag == "--heights") {
+                options.heights = std::stoi(value);
+            } else if (flag == "--rate") {
+                options.rate = std::stod(value);
+            } else if (flag == "--seed") {
+                options.seed = static_cast<uint32_t>(std::stoul(value));
+            } else if (flag == "--delay") {
+                options.delayMs = std::stoi(value);
+            } else if (flag == "--drop") {
+                options.dropRate = std::stod(value);
+            } else if (flag == "--metrics") {
+                options.metricsPath = value;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return options.validators > 0 && options.heights > 0 && options.rate >= 0.0;
+}
+
+uint64_t peakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss); // Bytes on macOS
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // KiB on Linux
+#endif
+#endif
+}
+
+void writePercentiles(std::ostream& os, const char* name, const HistogramSnapshot& snapshot) {
+    os << "\"" << name << "\":{\"p50\":" << snapshot.percentile(0.5) << ",\"p90\":" << snapshot.percentile(0.9)
+       << ",\"p99\":" << snapshot.percentile(0.99) << ",\"max\":" << snapshot.max << "}";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Keep stdout for the result
+    Logger& logger = Logger::instance();
+    logger.clearSinks();
+    logger.addSink(std::make_unique<TextLogSink>(stderr));
+    Logger::setLevel(LogLevel::WARN);
+
+    Network network;
+    network.setSeed(options.seed);
+    network.setMaxDelayMs(options.delayMs);
+    network.setMessageDropRate(options.dropRate);
+    network.setPipelinedExecution(options.pipeline);
+
+    std::vector<std::unique_ptr<StateMachine>> stateMachines;
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (int id = 1; id <= options.validators; ++id) {
+        stateMachines.push_back(std::make_unique<StateMachine>());
+        nodes.push_back(std::make_unique<Node>(id, &network, stateMachines.back().get()));
+        network.registerNode(nodes.back().get());
+    }
+    if (options.threads) {
+        network.setExecutionMode(ExecutionMode::THREAD_PER_NODE);
+    }
+
+    // Only the genesis accounts hold funds to send
+    const double amount = 0.01;
+    std::vector<Node*> senders;
+    for (const auto& node : nodes) {
+        if (stateMachines[0]->getBalance(node->getId()) >= amount) {
+            senders.push_back(node.get());
+        }
+    }
+
+    std::mt19937 load(options.seed);
+    std::uniform_int_distribution<size_t> pickSender(0, senders.size() - 1);
+    std::uniform_int_distribution<int> pickNode(0, options.validators - 1);
+    std::exponential_distribution<double> gapMs(options.rate / 1000.0);
+    double nextArrivalMs = options.rate > 0.0 ? gapMs(load) : 0.0;
+
+    Histogram heightWallUs;   // Wall time to decide, store and apply one height
+    Histogram heightNetworkMs; // Network time for the same
+    uint64_t arrived = 0;
+    uint64_t committed = 0;
+    int decided = 0;
+
+    auto submit = [&]() {
+        Node& sender = *senders[pickSender(load)];
+        int receiver = nodes[pickNode(load)]->getId();
+        sender.createTransaction(receiver, amount);
+        ++arrived;
+    };
+
+    auto wallStart = std::chrono::steady_clock::now();
+    long long networkStartMs = network.getCurrentTimeMs();
+    for (int height = 1; height <= options.heights; ++height) {
+        // Everything that arrived while the last height ran. An idle network does not advance its
+        // clock, so a height never starts empty: the next arrival is pulled forward instead.
+        long long nowMs = network.getCurrentTimeMs();
+        if (options.rate > 0.0) {
+            while (nextArrivalMs <= static_cast<double>(nowMs)) {
+                submit();
+                nextArrivalMs += gapMs(load);
+            }
+            if (!network.hasPendingTransactions()) {
+                submit();
+                nextArrivalMs = static_cast<double>(nowMs) + gapMs(load);
+            }
+        } else if (!network.hasPendingTransactions()) {
+            submit();
+        }
+
+        int lengthBefore = nodes[0]->getBlockchain().getChainLength();
+        uint64_t startUs = Metrics::nowUs();
+        nodes[(height - 1) % options.validators]->proposeBlock();
+        network.run();
+        heightWallUs.record(Metrics::nowUs() - startUs);
+        heightNetworkMs.record(static_cast<uint64_t>(network.getCurrentTimeMs() - nowMs));
+
+        const Blockchain& chain = nodes[0]->getBlockchain();
+        for (int index = lengthBefore; index < chain.getChainLength(); ++index) {
+            committed += chain.getBlock(index)->getTransactions().size();
+            ++decided;
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double networkSeconds = static_cast<double>(network.getCurrentTimeMs() - networkStartMs) / 1000.0;
+
+    bool consistent = true;
+    for (const auto& stateMachine : stateMachines) {
+        consistent = consistent && stateMachine->getStateRoot() == stateMachines[0]->getStateRoot();
+    }
+    for (const auto& node : nodes) {
+        consistent = consistent && node->getBlockchain().getChainLength() == nodes[0]->getBlockchain().getChainLength();
+    }
+
+    std::ostringstream result;
+    result << "{\"validators\":" << options.validators << ",\"heights\":" << options.heights << ",\"rate\":" << options.rate
+           << ",\"seed\":" << options.seed << ",\"delay_ms\":" << options.delayMs << ",\"drop_rate\":" << options.dropRate
+           << ",\"threads\":" << (options.threads ? "true" : "false") << ",\"pipeline\":" << (options.pipeline ? "true" : "false")
+           << ",\"blocks\":" << decided << ",\"transactions_arrived\":" << arrived << ",\"transactions_committed\":" << committed
+           << ",\"mempool_backlog\":" << network.getMempool().size() << ",\"wall_s\":" << wallSeconds
+           << ",\"network_s\":" << networkSeconds << ",\"tx_per_s\":" << (wallSeconds > 0 ? committed / wallSeconds : 0.0)
+           << ",\"blocks_per_s\":" << (wallSeconds > 0 ? decided / wallSeconds : 0.0)
+           << ",\"tx_per_network_s\":" << (networkSeconds > 0 ? committed / networkSeconds : 0.0) << ",";
+    writePercentiles(result, "commit_latency_us", heightWallUs.snapshot());
+    result << ",";
+    writePercentiles(result, "commit_latency_network_ms", heightNetworkMs.snapshot());
+    result << ",\"peak_rss_bytes\":" << peakRssBytes() << ",\"consistent\":" << (consistent ? "true" : "false") << "}";
+    std::cout << result.str() << std::endl;
+
+    if (!options.metricsPath.empty() && !Metrics::writePrometheusFile(options.metricsPath)) {
+        std::cerr << "Cannot write metrics to " << options.metricsPath << ".\n";
+    }
+    logger.flush();
+    return consistent ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+// Micro-benchmarks for the kernels a height spends its time in: block hashing, transaction
+// encoding, state apply, snapshots and rollback, and vote tallying. Run with
+// --benchmark_format=json to keep a baseline and compare against it.
+
+#include <benchmark/benchmark.h>
+#include "Block.h"
+#include "MerkleTree.h"
+#include "Transaction.h"
+#include "Serialization.h"
+#include "StateMachine.h"
+#include "ValidatorSet.h"
+#include "VoteSet.h"
+#include "Sha256.h"
+#include "Logger.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int FIRST_ACCOUNT = 5; // Above the genesis accounts
+const size_t BLOCK_TRANSACTIONS = 1000;
+
+// Transfers of one fixed-point unit around a cycle of randomly chosen accounts, so every account
+// gets back what it sent and applying the block over and over never runs anyone dry
+std::vector<Transaction> makeTransactions(size_t count, int accounts, uint32_t seed) {
+    std::vector<int> cycle(static_cast<size_t>(accounts));
+    for (int i = 0; i < accounts; ++i) {
+        cycle[static_cast<size_t>(i)] = FIRST_ACCOUNT + i;
+    }
+    std::mt19937 random(seed);
+    std::shuffle(cycle.begin(), cycle.end(), random);
+    cycle.resize(std::min(count, cycle.size()));
+
+    std::vector<Transaction> transactions;
+    transactions.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        transactions.emplace_back(cycle[i % cycle.size()], cycle[(i + 1) % cycle.size()], 0.000001, i, 0.0);
+    }
+    return transactions;
+}
+
+// State with the given number of funded accounts besides the genesis ones
+std::unique_ptr<StateMachine> makeState(int accounts) {
+    auto state = std::make_unique<StateMachine>();
+    std::vector<Transaction> funding;
+    funding.reserve(static_cast<size_t>(accounts));
+    for (int i = 0; i < accounts; ++i) {
+        funding.emplace_back(1, FIRST_ACCOUNT + i, 0.0005, static_cast<uint64_t>(i), 0.0);
+    }
+    state->applyTransactions(funding);
+    return state;
+}
+
+} // namespace
+
+// Merkle tree over the transactions plus the header hash; the copy of the list is included
+static void BM_BlockHash(benchmark::State& state) {
+    std::vector<Transaction> transactions = makeTransactions(static_cast<size_t>(state.range(0)), 1000, 1);
+    for (auto _ : state) {
+        Block block(1, Hash256(), transactions);
+        benchmark::DoNotOptimize(block.getHash());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BlockHash)->RangeMultiplier(10)->Range(1, 100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_MerkleTree(benchmark::State& state) {
+    std::vector<Transaction> transactions = makeTransactions(static_cast<size_t>(state.range(0)), 1000, 1);
+    for (auto _ : state) {
+        MerkleTree tree(transactions);
+        benchmark::DoNotOptimize(tree.getRoot());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MerkleTree)->RangeMultiplier(10)->Range(1, 100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_TransactionToString(benchmark::State& state) {
+    Transaction transaction(12, 34, 56.75, 7, 0.5);
+    for (auto _ : state) {
+        std::string text = transaction.toString();
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK(BM_TransactionToString);
+
+static void BM_TransactionSerialize(benchmark::State& state) {
+    Transaction transaction(12, 34, 56.75, 7, 0.5);
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        transaction.serialize(out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(Transaction::ENCODED_SIZE));
+}
+BENCHMARK(BM_TransactionSerialize);
+
+static void BM_TransactionDeserialize(benchmark::State& state) {
+    std::string encoded;
+    Transaction(12, 34, 56.75, 7, 0.5).serialize(encoded);
+    for (auto _ : state) {
+        ByteReader reader(encoded);
+        benchmark::DoNotOptimize(Transaction::deserialize(reader));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(Transaction::ENCODED_SIZE));
+}
+BENCHMARK(BM_TransactionDeserialize);
+
+static void BM_TransactionHash(benchmark::State& state) {
+    Transaction transaction(12, 34, 56.75, 7, 0.5);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(transaction.getHash());
+    }
+}
+BENCHMARK(BM_TransactionHash);
+
+// One block prepared and committed, as the block executor applies it
+static void BM_StateApply(benchmark::State& state) {
+    int accounts = static_cast<int>(state.range(0));
+    std::unique_ptr<StateMachine> stateMachine = makeState(accounts);
+    std::vector<Transaction> block = makeTransactions(static_cast<size_t>(state.range(1)), accounts, 2);
+    for (auto _ : state) {
+        stateMachine->prepareState(block);
+        stateMachine->commitState();
+        stateMachine->releaseSnapshots();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_StateApply)
+    ->ArgsProduct({{1000, 10000, 100000, 1000000}, {static_cast<int64_t>(BLOCK_TRANSACTIONS), 10000}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Snapshot, apply a block, and undo it again
+static void BM_StateSnapshotRollback(benchmark::State& state) {
+    int accounts = static_cast<int>(state.range(0));
+    std::unique_ptr<StateMachine> stateMachine = makeState(accounts);
+    stateMachine->releaseSnapshots();
+    std::vector<Transaction> block = makeTransactions(BLOCK_TRANSACTIONS, accounts, 3);
+    for (auto _ : state) {
+        stateMachine->createSnapshot();
+        stateMachine->prepareState(block);
+        stateMachine->commitState();
+        stateMachine->rollbackState();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(BLOCK_TRANSACTIONS));
+}
+BENCHMARK(BM_StateSnapshotRollback)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+// Read after every executed block; kept up to date by the writes, so flat in the account count
+static void BM_StateRoot(benchmark::State& state) {
+    std::unique_ptr<StateMachine> stateMachine = makeState(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(stateMachine->getStateRoot());
+    }
+}
+BENCHMARK(BM_StateRoot)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// The on-disk snapshot: encoding sorts and checksums every account
+static void BM_StateEncodeSnapshot(benchmark::State& state) {
+    std::unique_ptr<StateMachine> stateMachine = makeState(static_cast<int>(state.range(0)));
+    std::string bytes;
+    for (auto _ : state) {
+        bytes.clear();
+        stateMachine->encodeSnapshot(bytes, 1);
+        benchmark::DoNotOptimize(bytes.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes.size()));
+}
+BENCHMARK(BM_StateEncodeSnapshot)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_StateRestoreSnapshot(benchmark::State& state) {
+    std::unique_ptr<StateMachine> stateMachine = makeState(static_cast<int>(state.range(0)));
+    std::string bytes;
+    stateMachine->encodeSnapshot(bytes, 1);
+    StateMachine restored;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(restored.restoreSnapshot(bytes));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes.size()));
+}
+BENCHMARK(BM_StateRestoreSnapshot)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+// Every validator's prevote for one round, looked up and tallied the way Consensus does it
+static void BM_VoteTally(benchmark::State& state) {
+    size_t validatorCount = static_cast<size_t>(state.range(0));
+    ValidatorSet validators;
+    std::vector<std::pair<int, uint64_t>> members;
+    for (size_t i = 0; i < validatorCount; ++i) {
+        members.emplace_back(static_cast<int>(i + 1), 1);
+    }
+    validators.update(members);
+    Hash256 proposal = Sha256::digest("proposal", 8);
+
+    VoteSet votes;
+    uint32_t round = 0;
+    for (auto _ : state) {
+        votes.reset(1, round++, MessageType::PREVOTE, validators.size(), validators.getQuorumPower());
+        bool quorum = false;
+        for (const Validator& validator : validators.getValidators()) {
+            size_t index = validators.getIndex(validator.id);
+            if (votes.addVote(index, proposal, validators.getValidator(index).votingPower)) {
+                quorum = votes.hasQuorum(proposal);
+            }
+        }
+        benchmark::DoNotOptimize(quorum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VoteTally)->Arg(4)->Arg(10)->Arg(100)->Arg(1000);
+
+int main(int argc, char** argv) {
+    Logger::setLevel(LogLevel::ERROR); // Failed transfers and rollbacks would flood the output
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    Logger::instance().flush();
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "Node.h"
 #include "Network.h"
 #include "StateMachine.h"
+#include "Config.h"
 #include <iostream>
 #include <memory>
 #include <string>
@@ -8,22 +9,28 @@
 #include <sstream>
 #include <iomanip> // For formatting output
 #include "Utils.h"
+#include "Logger.h"
+#include "Metrics.h"
 
 int main() {
-    // Shared state machine and initial nodes
-    StateMachine stateMachine;
+    // Every node keeps its own replica of the state machine and applies each committed block to it
+    std::vector<std::unique_ptr<StateMachine>> stateMachines;
     std::vector<std::unique_ptr<Node>> nodes;
 
-    Network network(&stateMachine); // Pass StateMachine to the Network
+    Network network;
 
     // Configure network parameters
-    network.setMessageDropRate(0.01);  // 10% message drop rate
+    network.setMessageDropRate(0.01);  // 1% per delivery attempt
     network.setMaxDelayMs(200);      // Max delay of 200 milliseconds
+    network.setClockMode(ClockMode::WALL_CLOCK); // Let the demo actually wait for the delays
 
     // Initialize 4 nodes
     int initialNodeCount = 4;
     for (int i = 0; i < initialNodeCount; ++i) {
-        nodes.push_back(std::make_unique<Node>(i + 1, &network, &stateMachine));
+        stateMachines.push_back(std::make_unique<StateMachine>());
+        nodes.push_back(std::make_unique<Node>(i + 1, &network, stateMachines.back().get()));
+        // Each node keeps its chain, state snapshots and consensus WAL under data/node-<id> and resumes from them
+        nodes.back()->openStorage(Config::getDataDirectory() + "/node-" + std::to_string(i + 1));
     }
 
     // Register initial nodes in the network
@@ -34,6 +41,7 @@ int main() {
     // Interactive client
     std::string command;
     while (true) {
+        Logger::instance().flush(); // Let the log catch up before the prompt
         std::cout << "Enter command (help for a list of commands): ";
         std::getline(std::cin, command);
 
@@ -45,14 +53,23 @@ int main() {
                 std::cout << "  start <node_id>  - Start consensus from a specific node\n";
                 std::cout << "  rollback <node_id> - Rollback the consensus state for a node\n";
                 std::cout << "  status <node_id> - Show the current state of a node\n";
-                std::cout << "  create_transaction <sender_id> <receiver_id> <amount> - Create a transaction\n";
+                std::cout << "  create_transaction <sender_id> <receiver_id> <amount> [fee] - Create a transaction\n";
                 std::cout << "  add_node - Add a new node dynamically to the network\n";
+                std::cout << "  power <node_id> <voting_power> - Change a validator's voting power from the next height (0 removes it)\n";
+                std::cout << "  mempool [fifo|fee] - Show the mempool or change its ordering\n";
+                std::cout << "  threads <on|off> - Run each node on its own worker thread\n";
+                std::cout << "  pipeline <on|off> - Vote on the next height while the last block is stored and applied\n";
+                std::cout << "  log <trace|debug|info|warn|error|off> - Set the log level\n";
+                std::cout << "  log <json|binary> <path> - Also write the log to a file\n";
+                std::cout << "  metrics [path] - Print metrics in the Prometheus text format, or write them to a file\n";
                 std::cout << "  exit - Exit the program\n";
             } else if (command.find("start") == 0) {
                 int nodeId = std::stoi(command.substr(6));
                 if (nodeId > 0 && nodeId <= static_cast<int>(nodes.size())) {
                     try {
                         nodes[nodeId - 1]->proposeBlock();
+                        size_t delivered = network.run(); // Deliver every message the round produces
+                        std::cout << "Round complete: " << delivered << " messages delivered.\n";
                     } catch (const std::exception& e) {
                         std::cerr << "[ERROR] Exception occurred during consensus: " << e.what() << std::endl;
                     }
@@ -63,6 +80,7 @@ int main() {
                 int nodeId = std::stoi(command.substr(9));
                 if (nodeId > 0 && nodeId <= static_cast<int>(nodes.size())) {
                     nodes[nodeId - 1]->rollbackConsensus();
+                    network.run();
                 } else {
                     std::cout << "Invalid node ID. Please enter a value between 1 and " << nodes.size() << ".\n";
                 }
@@ -86,23 +104,94 @@ int main() {
                 try {
                     int senderId, receiverId;
                     double amount;
+                    double fee = 0.0;
                     std::istringstream ss(command);
                     std::string token;
                     ss >> token >> senderId >> receiverId >> amount;
+                    ss >> fee; // Optional, orders the mempool when fee ordering is enabled
 
                     if (senderId > 0 && senderId <= static_cast<int>(nodes.size()) && receiverId > 0 && receiverId <= static_cast<int>(nodes.size())) {
-                        nodes[senderId - 1]->createTransaction(receiverId, amount);
+                        nodes[senderId - 1]->createTransaction(receiverId, amount, fee);
                     } else {
                         std::cout << "Invalid node ID or transaction parameters. Please check your input.\n";
                     }
                 } catch (const std::exception& e) {
                     std::cout << "Error processing transaction: " << e.what() << "\n";
                 }
+            } else if (command.find("mempool") == 0) {
+                Mempool& mempool = network.getMempool();
+                std::string ordering = command.size() > 8 ? command.substr(8) : "";
+                if (ordering == "fifo") {
+                    mempool.setOrdering(MempoolOrdering::FIFO);
+                } else if (ordering == "fee") {
+                    mempool.setOrdering(MempoolOrdering::FEE);
+                }
+                std::cout << "Mempool: " << mempool.size() << " transactions, " << mempool.sizeBytes() << " bytes, "
+                          << (mempool.getOrdering() == MempoolOrdering::FEE ? "fee" : "fifo") << " ordering\n";
+            } else if (command.find("threads") == 0) {
+                std::string mode = command.size() > 8 ? command.substr(8) : "";
+                if (mode == "on") {
+                    network.setExecutionMode(ExecutionMode::THREAD_PER_NODE);
+                    std::cout << "Nodes now run on " << nodes.size() << " worker threads.\n";
+                } else if (mode == "off") {
+                    network.setExecutionMode(ExecutionMode::SINGLE_THREADED);
+                    std::cout << "Nodes now run on the main thread.\n";
+                } else {
+                    std::cout << "Usage: threads <on|off>\n";
+                }
+            } else if (command.find("metrics") == 0) {
+                std::string path = command.size() > 8 ? command.substr(8) : "";
+                if (path.empty()) {
+                    Metrics::writePrometheus(std::cout);
+                } else if (Metrics::writePrometheusFile(path)) {
+                    std::cout << "Metrics written to " << path << ".\n";
+                } else {
+                    std::cout << "Cannot write metrics to " << path << ".\n";
+                }
+            } else if (command.find("log") == 0) {
+                std::istringstream ss(command);
+                std::string token, argument, path;
+                ss >> token >> argument >> path;
+                LogLevel level;
+                if (argument == "json" && !path.empty()) {
+                    Logger::instance().addSink(std::make_unique<JsonLogSink>(path));
+                    std::cout << "Logging JSON to " << path << ".\n";
+                } else if (argument == "binary" && !path.empty()) {
+                    Logger::instance().addSink(std::make_unique<BinaryLogSink>(path));
+                    std::cout << "Logging binary records to " << path << ".\n";
+                } else if (Logger::parseLevel(argument, level)) {
+                    Logger::setLevel(level);
+                    std::cout << "Log level set to " << Logger::levelName(level) << ".\n";
+                } else {
+                    std::cout << "Usage: log <trace|debug|info|warn|error|off> or log <json|binary> <path>\n";
+                }
+            } else if (command.find("pipeline") == 0) {
+                std::string mode = command.size() > 9 ? command.substr(9) : "";
+                if (mode == "on" || mode == "off") {
+                    network.setPipelinedExecution(mode == "on");
+                    std::cout << "Pipelined execution " << (mode == "on" ? "enabled" : "disabled") << ".\n";
+                } else {
+                    std::cout << "Usage: pipeline <on|off>\n";
+                }
+            } else if (command.find("power") == 0) {
+                std::istringstream ss(command);
+                std::string token;
+                int nodeId = 0;
+                long long votingPower = -1;
+                ss >> token >> nodeId >> votingPower;
+                if (nodeId > 0 && nodeId <= static_cast<int>(nodes.size()) && votingPower >= 0) {
+                    network.setVotingPower(nodeId, static_cast<uint64_t>(votingPower));
+                    std::cout << "Node " << nodeId << " will have voting power " << votingPower << " from the next height.\n";
+                } else {
+                    std::cout << "Usage: power <node_id> <voting_power>\n";
+                }
             } else if (command == "add_node") {
                 int newId = static_cast<int>(network.getTotalNodes() + 1); // Dynamically assign an ID
-                auto newNode = std::make_unique<Node>(newId, &network, &stateMachine);
+                stateMachines.push_back(std::make_unique<StateMachine>());
+                auto newNode = std::make_unique<Node>(newId, &network, stateMachines.back().get());
+                newNode->openStorage(Config::getDataDirectory() + "/node-" + std::to_string(newId));
                 network.registerNode(newNode.get());
-                stateMachine.prepareState({Transaction(0, newId, 0)}); // Start with a default balance
+                stateMachines.back()->prepareState({Transaction(0, newId, 0)}); // Start with a default balance
                 nodes.push_back(std::move(newNode));
                 std::cout << "Node " << newId << " added to the network.\n";
             } else {
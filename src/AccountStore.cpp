@@ -0,0 +1,62 @@
+#include "AccountStore.h"
+#include <cmath>
+
+Amount AccountStore::toAmount(double value) {
+    return static_cast<Amount>(std::llround(value * AMOUNT_SCALE));
+}
+
+double AccountStore::toDouble(Amount amount) {
+    return static_cast<double>(amount) / AMOUNT_SCALE;
+}
+
+uint32_t AccountStore::findSlot(int id) const {
+    if (id >= 0 && id < DIRECT_IDS) {
+        return static_cast<size_t>(id) < directSlots.size() ? directSlots[id] : NO_SLOT;
+    }
+    auto it = sparseSlots.find(id);
+    return it != sparseSlots.end() ? it->second : NO_SLOT;
+}
+
+uint32_t AccountStore::slotFor(int id) {
+    uint32_t slot = findSlot(id);
+    if (slot != NO_SLOT) {
+        return slot;
+    }
+
+    slot = static_cast<uint32_t>(ids.size());
+    balances.push_back(0);
+    nonces.push_back(0);
+    flags.push_back(0);
+    ids.push_back(id);
+
+    if (id >= 0 && id < DIRECT_IDS) {
+        if (static_cast<size_t>(id) >= directSlots.size()) {
+            directSlots.resize(static_cast<size_t>(id) + 1, NO_SLOT);
+        }
+        directSlots[id] = slot;
+    } else {
+        sparseSlots.emplace(id, slot);
+    }
+    return slot;
+}
+
+void AccountStore::setAccount(uint32_t slot, Amount balance, uint64_t nonce) {
+    balances[slot] = balance;
+    nonces[slot] = nonce;
+    flags[slot] |= FLAG_EXISTS;
+}
+
+void AccountStore::removeAccount(uint32_t slot) {
+    balances[slot] = 0;
+    nonces[slot] = 0;
+    flags[slot] &= static_cast<uint8_t>(~FLAG_EXISTS);
+}
+
+void AccountStore::clear() {
+    balances.clear();
+    nonces.clear();
+    flags.clear();
+    ids.clear();
+    directSlots.clear();
+    sparseSlots.clear();
+}
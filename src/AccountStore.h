@@ -0,0 +1,49 @@
+#ifndef ACCOUNT_STORE_H
+#define ACCOUNT_STORE_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Balances in fixed-point micro-units, so applying a block never accumulates rounding error
+using Amount = int64_t;
+
+// Accounts laid out as parallel arrays indexed by a dense slot number. Small non-negative
+// ids (node ids) map to slots through a flat table; anything else goes through a hash map.
+// Slots are never reused, so a slot stays valid for the lifetime of the store.
+class AccountStore {
+public:
+    static constexpr Amount AMOUNT_SCALE = 1000000;
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    static constexpr uint8_t FLAG_EXISTS = 0x01; // Cleared when a rollback removes an account
+
+    static Amount toAmount(double value);
+    static double toDouble(Amount amount);
+
+    uint32_t findSlot(int id) const; // NO_SLOT if the id was never seen
+    uint32_t slotFor(int id);        // Allocates a slot (without FLAG_EXISTS) on first use
+
+    size_t slotCount() const { return ids.size(); }
+    int getId(uint32_t slot) const { return ids[slot]; }
+    bool exists(uint32_t slot) const { return flags[slot] & FLAG_EXISTS; }
+    Amount getBalance(uint32_t slot) const { return balances[slot]; } // 0 for accounts that do not exist
+    uint64_t getNonce(uint32_t slot) const { return nonces[slot]; }
+
+    void setAccount(uint32_t slot, Amount balance, uint64_t nonce); // Also marks the account as existing
+    void removeAccount(uint32_t slot);
+    void clear(); // Forget every account and slot
+
+private:
+    static constexpr int DIRECT_IDS = 1 << 16; // Ids below this skip the hash map
+
+    std::vector<Amount> balances;
+    std::vector<uint64_t> nonces;
+    std::vector<uint8_t> flags;
+    std::vector<int> ids;
+
+    std::vector<uint32_t> directSlots;
+    std::unordered_map<int, uint32_t> sparseSlots;
+};
+
+#endif
@@ -1,47 +1,94 @@
 #include "Block.h"
-#include <sstream>
-#include <openssl/sha.h>
+#include "Serialization.h"
+#include "Sha256.h"
+#include "MerkleTree.h"
+#include "Metrics.h"
+#include <cstring>
+#include <stdexcept>
 
-Block::Block(int index, const std::string& previousHash, const std::vector<Transaction>& transactions)
-    : index(index), previousHash(previousHash), transactions(transactions) {
+Block::Block(int index, const Hash256& previousHash, std::vector<Transaction> transactions, const Hash256& appHash)
+    : index(index), previousHash(previousHash), appHash(appHash), transactions(std::move(transactions)) {
     
+    static Histogram& hashUs = Metrics::histogram("block_hash_us", "Building a block's merkle tree and header hash");
+
     // Calculate hash
+    uint64_t startUs = Metrics::nowUs();
+    merkleRoot = MerkleTree(this->transactions).getRoot();
     hash = calculateHash();
+    hashUs.record(Metrics::nowUs() - startUs);
 }
 
-std::string Block::calculateHash() const {
-    std::stringstream ss;
-    ss << index << previousHash;
-
-    // Iterate over each transaction and add the string representation of the transaction to the hash input
-    for (const auto& tx : transactions) {
-        ss << tx.toString();
-    }
+Hash256 Block::calculateHash() const {
+    // Only the fixed-size header is hashed; the merkle root stands in for the transactions
+    uint8_t header[HEADER_SIZE];
+    storeU64(header, static_cast<uint64_t>(static_cast<int64_t>(index)));
+    std::memcpy(header + 8, previousHash.data(), Hash256::SIZE);
+    std::memcpy(header + 8 + Hash256::SIZE, merkleRoot.data(), Hash256::SIZE);
+    std::memcpy(header + 8 + 2 * Hash256::SIZE, appHash.data(), Hash256::SIZE);
+    storeU32(header + 8 + 3 * Hash256::SIZE, static_cast<uint32_t>(transactions.size()));
 
-    std::string input = ss.str();
-    unsigned char hashBytes[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)input.c_str(), input.size(), hashBytes);
+    Sha256 hasher;
+    hasher.update(header, sizeof(header));
+    return hasher.finish();
+}
 
-    std::stringstream hashString;
-    for (unsigned char byte : hashBytes) {
-        hashString << std::hex << (int)byte;
-    }
+const Hash256& Block::getHash() const {
+    return hash;
+}
 
-    return hashString.str();
+const Hash256& Block::getMerkleRoot() const {
+    return merkleRoot;
 }
 
-std::string Block::getHash() const {
-    return hash;
+MerkleProof Block::getMerkleProof(size_t transactionIndex) const {
+    return MerkleTree(transactions).getProof(transactionIndex);
 }
 
 int Block::getIndex() const {
     return index;
 }
 
-std::string Block::getPreviousHash() const {
+const Hash256& Block::getPreviousHash() const {
     return previousHash;
 }
 
+const Hash256& Block::getAppHash() const {
+    return appHash;
+}
+
 const std::vector<Transaction>& Block::getTransactions() const {
     return transactions;
 }
+
+void Block::serialize(std::string& out) const {
+    out.reserve(out.size() + 12 + 2 * Hash256::SIZE + transactions.size() * Transaction::ENCODED_SIZE);
+    ByteWriter writer(out);
+    writer.writeI64(index);
+    writer.writeBytes(previousHash.data(), Hash256::SIZE);
+    writer.writeBytes(appHash.data(), Hash256::SIZE);
+    writer.writeU32(static_cast<uint32_t>(transactions.size()));
+    for (const auto& tx : transactions) {
+        tx.serialize(out);
+    }
+}
+
+Block Block::deserialize(std::string_view bytes) {
+    ByteReader reader(bytes);
+    int index = static_cast<int>(reader.readI64());
+    Hash256 previousHash = Hash256::fromBytes(reader.readBytes(Hash256::SIZE).data());
+    Hash256 appHash = Hash256::fromBytes(reader.readBytes(Hash256::SIZE).data());
+    uint32_t count = reader.readU32();
+    if (count > bytes.size() / Transaction::ENCODED_SIZE) {
+        throw std::runtime_error("Block claims more transactions than it holds.");
+    }
+
+    std::vector<Transaction> transactions;
+    transactions.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        transactions.push_back(Transaction::deserialize(reader));
+    }
+    if (!reader.atEnd()) {
+        throw std::runtime_error("Trailing bytes after block.");
+    }
+    return Block(index, previousHash, std::move(transactions), appHash);
+}
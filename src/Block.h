@@ -2,27 +2,42 @@
 #define BLOCK_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include "Transaction.h"
+#include "Hash256.h"
+#include "MerkleTree.h"
 
 class Block {
 public:
-    Block(int index, const std::string& previousHash, const std::vector<Transaction>& transactions);
+    // appHash is the state root some earlier height left behind; consensus decides which one
+    Block(int index, const Hash256& previousHash, std::vector<Transaction> transactions, const Hash256& appHash = Hash256());
 
-    std::string getHash() const;
+    const Hash256& getHash() const;       // SHA-256 of the header
+    const Hash256& getMerkleRoot() const; // Commits to every transaction in the block
+    // Lets a light client check one transaction against the header. Rebuilds the tree, so O(n).
+    MerkleProof getMerkleProof(size_t transactionIndex) const;
     int getIndex() const;
-    std::string getPreviousHash() const;
+    const Hash256& getPreviousHash() const;
+    const Hash256& getAppHash() const;
 
     // Return to transaction list
     const std::vector<Transaction>& getTransactions() const; 
 
+    void serialize(std::string& out) const;           // Append the binary encoding
+    static Block deserialize(std::string_view bytes); // Throws std::runtime_error on malformed input
+
+    static const size_t HEADER_SIZE = 8 + 3 * Hash256::SIZE + 4; // index, previous hash, merkle root, app hash, tx count
+
 private:
     int index;
-    std::string previousHash;
+    Hash256 previousHash;
+    Hash256 appHash;
     std::vector<Transaction> transactions;
-    std::string hash;
+    Hash256 merkleRoot; // Only the root is kept; the levels below it would cost 64 bytes per transaction
+    Hash256 hash;
 
-    std::string calculateHash() const;
+    Hash256 calculateHash() const;
 };
 
 #endif
@@ -0,0 +1,47 @@
+#include "BlockCache.h"
+
+BlockCache::BlockCache(size_t capacity) : capacity(capacity) {}
+
+std::shared_ptr<const Block> BlockCache::get(int height) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = byHeight.find(height);
+    if (it == byHeight.end()) {
+        return nullptr;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void BlockCache::put(int height, std::shared_ptr<const Block> block) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (capacity == 0) {
+        return;
+    }
+    auto it = byHeight.find(height);
+    if (it != byHeight.end()) {
+        it->second->second = std::move(block);
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    if (entries.size() >= capacity) {
+        byHeight.erase(entries.back().first);
+        entries.pop_back();
+    }
+    entries.emplace_front(height, std::move(block));
+    byHeight[height] = entries.begin();
+}
+
+void BlockCache::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.clear();
+    byHeight.clear();
+}
+
+size_t BlockCache::size() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return entries.size();
+}
+
+size_t BlockCache::getCapacity() const {
+    return capacity;
+}
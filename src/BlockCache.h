@@ -0,0 +1,33 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include "Block.h"
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Least-recently-used cache of decoded blocks by height. Callers hold shared pointers,
+// so evicting a block never invalidates one that is still in use.
+class BlockCache {
+public:
+    explicit BlockCache(size_t capacity);
+
+    std::shared_ptr<const Block> get(int height); // Null on a miss
+    void put(int height, std::shared_ptr<const Block> block);
+    void clear();
+
+    size_t size() const;
+    size_t getCapacity() const;
+
+private:
+    using Entry = std::pair<int, std::shared_ptr<const Block>>;
+
+    size_t capacity;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<int, std::list<Entry>::iterator> byHeight;
+    mutable std::mutex cacheMutex;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "BlockExecutor.h"
+#include "Node.h"
+#include "Config.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+BlockExecutor::BlockExecutor(Node* node, StateMachine* stateMachine)
+    : node(node), stateMachine(stateMachine), busy(false), stopping(false) {}
+
+BlockExecutor::~BlockExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    workCondition.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool BlockExecutor::execute(const Block& block) {
+    static Histogram& storeUs = Metrics::histogram("block_store_us", "Adding a decided block to the chain and block store");
+    static Histogram& applyUs = Metrics::histogram("state_apply_us", "Preparing and committing a block's transactions");
+    static Counter& applied = Metrics::counter("state_transactions_applied_total", "Transactions in blocks applied to the state");
+
+    uint64_t startUs = Metrics::nowUs();
+    if (!node->getBlockchain().addBlock(block)) {
+        LOG_ERROR("Finalized block rejected by the local chain.");
+        return false;
+    }
+    storeUs.record(Metrics::nowUs() - startUs);
+
+    const std::vector<Transaction>& transactions = block.getTransactions();
+    if (!transactions.empty() && stateMachine) {
+        LOG_DEBUG("Transactions before processing (Consensus): " + std::to_string(transactions.size()));
+        startUs = Metrics::nowUs();
+        stateMachine->prepareState(transactions);
+        stateMachine->commitState();
+        applyUs.record(Metrics::nowUs() - startUs);
+        applied.increment(transactions.size());
+        stateMachine->printState();
+    } else {
+        LOG_DEBUG("No transactions to process.");
+    }
+    if (stateMachine) {
+        // Nothing left to roll back to, and the undo journal stops growing. Empty blocks too: the
+        // proposer took a snapshot for them all the same.
+        stateMachine->releaseSnapshots();
+        recordAppHash(static_cast<uint64_t>(block.getIndex()), stateMachine->getStateRoot());
+    }
+
+    SnapshotStore* snapshots = node->getSnapshotStore();
+    if (snapshots && stateMachine && block.getIndex() % Config::getSnapshotInterval() == 0) {
+        try {
+            snapshots->save(*stateMachine, static_cast<uint64_t>(block.getIndex()));
+        } catch (const std::exception& e) {
+            LOG_ERROR("State snapshot for block " + std::to_string(block.getIndex()) + " failed: " + e.what());
+        }
+    }
+    return true;
+}
+
+void BlockExecutor::submit(std::shared_ptr<const Block> block) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(block));
+        if (!worker.joinable()) {
+            worker = std::thread(&BlockExecutor::workerLoop, this);
+        }
+    }
+    workCondition.notify_one();
+}
+
+void BlockExecutor::waitIdle() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    idleCondition.wait(lock, [this] { return queue.empty() && !busy; });
+}
+
+bool BlockExecutor::isIdle() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queue.empty() && !busy;
+}
+
+void BlockExecutor::workerLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        workCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return; // Stopping with nothing left to apply
+        }
+        std::shared_ptr<const Block> block = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+        lock.unlock();
+
+        try {
+            execute(*block);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Executing block " + std::to_string(block->getIndex()) + " failed: " + e.what());
+        }
+
+        lock.lock();
+        busy = false;
+        if (queue.empty()) {
+            idleCondition.notify_all();
+        }
+    }
+}
+
+std::optional<Hash256> BlockExecutor::getAppHash(uint64_t height) const {
+    std::lock_guard<std::mutex> lock(appHashMutex);
+    auto found = appHashes.find(height);
+    if (found == appHashes.end()) {
+        return std::nullopt;
+    }
+    return found->second;
+}
+
+void BlockExecutor::recordAppHash(uint64_t height, const Hash256& root) {
+    std::lock_guard<std::mutex> lock(appHashMutex);
+    appHashes[height] = root;
+    while (appHashes.size() > APP_HASH_HISTORY) {
+        appHashes.erase(appHashes.begin());
+    }
+}
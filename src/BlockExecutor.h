@@ -0,0 +1,59 @@
+#ifndef BLOCK_EXECUTOR_H
+#define BLOCK_EXECUTOR_H
+
+#include "Block.h"
+#include "Hash256.h"
+#include "StateMachine.h"
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+class Node;
+
+// Stores decided blocks in a node's chain, applies them to its state and takes the periodic
+// state snapshots. execute() does this on the calling thread; submit() queues the block for a
+// background thread instead, so consensus can vote on the next height while this one is written
+// and applied (pipelined execution). Blocks are handled strictly in the order they are handed in.
+// The state root after each block is remembered for the app hash of a later block.
+class BlockExecutor {
+public:
+    BlockExecutor(Node* node, StateMachine* stateMachine);
+    ~BlockExecutor(); // Finishes the queued blocks first
+
+    BlockExecutor(const BlockExecutor&) = delete;
+    BlockExecutor& operator=(const BlockExecutor&) = delete;
+
+    bool execute(const Block& block); // False if the chain rejects the block
+    void submit(std::shared_ptr<const Block> block);
+    void waitIdle(); // Returns once every submitted block is stored and applied
+    bool isIdle() const;
+
+    std::optional<Hash256> getAppHash(uint64_t height) const; // State root after height, if still remembered
+    void recordAppHash(uint64_t height, const Hash256& root);
+
+    static const size_t APP_HASH_HISTORY = 4; // Roots kept; consensus only looks a couple of heights back
+
+private:
+    Node* node;
+    StateMachine* stateMachine;
+
+    std::deque<std::shared_ptr<const Block>> queue;
+    bool busy; // The worker holds a block it took off the queue
+    bool stopping;
+    std::thread worker; // Started by the first submit
+    mutable std::mutex queueMutex;
+    std::condition_variable workCondition;
+    std::condition_variable idleCondition;
+
+    std::map<uint64_t, Hash256> appHashes;
+    mutable std::mutex appHashMutex;
+
+    void workerLoop();
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "BlockStore.h"
+#include "Serialization.h"
+#include "Utils.h"
+#include "Logger.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+BlockStore::BlockStore(const std::string& directory, size_t segmentBytes, FsyncPolicy fsyncPolicy)
+    : directory(directory),
+      segmentBytes(segmentBytes),
+      fsyncPolicy(fsyncPolicy),
+      indexedCount(0),
+      activeFile(nullptr),
+      activeSegment(0),
+      activeSize(0),
+      indexFile(nullptr) {
+    fs::create_directories(directory);
+    recover();
+    activeFile = openForAppend(segmentPath(activeSegment));
+    indexFile = openForAppend(indexPath());
+}
+
+BlockStore::~BlockStore() {
+    try {
+        sync();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Block store not synced on close: " + std::string(e.what()));
+    }
+    if (activeFile) {
+        std::fclose(activeFile);
+    }
+    if (indexFile) {
+        std::fclose(indexFile);
+    }
+}
+
+void BlockStore::recover() {
+    uint32_t segmentCount = 0;
+    while (fs::exists(segmentPath(segmentCount))) {
+        ++segmentCount;
+    }
+    if (segmentCount == 0) {
+        std::ofstream(segmentPath(0), std::ios::binary);
+        segmentCount = 1;
+    }
+
+    // Trust index entries only while they chain record to record and stay inside their files
+    std::vector<uint64_t> segmentSizes(segmentCount);
+    for (uint32_t segment = 0; segment < segmentCount; ++segment) {
+        segmentSizes[segment] = fs::file_size(segmentPath(segment));
+    }
+    if (fs::exists(indexPath())) {
+        std::ifstream input(indexPath(), std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        ByteReader reader(bytes);
+        uint32_t expectedSegment = 0;
+        uint64_t expectedOffset = 0;
+        for (size_t i = 0; i < bytes.size() / INDEX_ENTRY_SIZE; ++i) {
+            Location location;
+            location.segment = reader.readU32();
+            location.offset = reader.readU64();
+            location.length = reader.readU32();
+            bool continues = location.segment == expectedSegment && location.offset == expectedOffset;
+            bool startsNext = location.segment == expectedSegment + 1 && location.offset == 0;
+            if ((!continues && !startsNext) || location.segment >= segmentCount ||
+                location.offset + 4 + location.length > segmentSizes[location.segment]) {
+                break;
+            }
+            locations.push_back(location);
+            expectedSegment = location.segment;
+            expectedOffset = location.offset + 4 + location.length;
+        }
+        if (bytes.size() != locations.size() * INDEX_ENTRY_SIZE) {
+            fs::resize_file(indexPath(), locations.size() * INDEX_ENTRY_SIZE);
+        }
+    }
+    indexedCount = locations.size();
+
+    // Pick up blocks appended after the last index write
+    Hash256 previousHash;
+    uint32_t segment = 0;
+    uint64_t offset = 0;
+    if (!locations.empty()) {
+        const Location& last = locations.back();
+        previousHash = readBlock(locations.size() - 1).getHash();
+        segment = last.segment;
+        offset = last.offset + 4 + last.length;
+    }
+    for (; segment < segmentCount; ++segment, offset = 0) {
+        MappedFile file;
+        file.open(segmentPath(segment));
+        while (offset + 4 <= file.size()) {
+            uint32_t length = ByteReader(file.view(offset, 4)).readU32();
+            if (offset + 4 + length > file.size()) {
+                break; // Torn write
+            }
+            try {
+                Block block = Block::deserialize(file.view(offset + 4, length));
+                if (block.getIndex() != static_cast<int>(locations.size()) ||
+                    (!locations.empty() && block.getPreviousHash() != previousHash)) {
+                    break;
+                }
+                previousHash = block.getHash();
+            } catch (const std::exception&) {
+                break;
+            }
+            locations.push_back({segment, offset, length});
+            offset += 4 + length;
+        }
+
+        if (offset < file.size()) {
+            file.close();
+            segmentMaps.clear(); // Never keep a map over bytes about to be cut off
+            LOG_WARN("Discarding " + std::to_string(segmentSizes[segment] - offset) + " unreadable bytes at the end of " + segmentPath(segment));
+            fs::resize_file(segmentPath(segment), offset);
+            for (uint32_t later = segment + 1; later < segmentCount; ++later) {
+                fs::remove(segmentPath(later));
+            }
+            segmentCount = segment + 1;
+            break;
+        }
+    }
+
+    activeSegment = segmentCount - 1;
+    activeSize = fs::file_size(segmentPath(activeSegment));
+}
+
+void BlockStore::append(const Block& block) {
+    if (block.getIndex() != static_cast<int>(locations.size())) {
+        throw std::runtime_error("Block " + std::to_string(block.getIndex()) + " appended out of order.");
+    }
+
+    std::string record(4, '\0');
+    block.serialize(record);
+    uint32_t length = static_cast<uint32_t>(record.size() - 4);
+    storeU32(reinterpret_cast<uint8_t*>(&record[0]), length);
+
+    if (activeSize > 0 && activeSize + record.size() > segmentBytes) {
+        rollSegment();
+    }
+    if (std::fwrite(record.data(), 1, record.size(), activeFile) != record.size() || std::fflush(activeFile) != 0) {
+        throw std::runtime_error("Cannot write to " + segmentPath(activeSegment));
+    }
+    if (fsyncPolicy == FsyncPolicy::EVERY_BLOCK && !Utils::syncFile(activeFile)) {
+        throw std::runtime_error("Cannot sync " + segmentPath(activeSegment));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(readMutex);
+        locations.push_back({activeSegment, activeSize, length});
+    }
+    activeSize += record.size();
+
+    if (locations.size() - indexedCount >= Config::getIndexFlushInterval()) {
+        flushIndex();
+    }
+}
+
+void BlockStore::rollSegment() {
+    if (fsyncPolicy != FsyncPolicy::NEVER && !Utils::syncFile(activeFile)) {
+        throw std::runtime_error("Cannot sync " + segmentPath(activeSegment));
+    }
+    std::fclose(activeFile);
+    activeFile = nullptr;
+
+    ++activeSegment;
+    activeSize = 0;
+    activeFile = openForAppend(segmentPath(activeSegment));
+}
+
+void BlockStore::flushIndex() {
+    if (indexedCount == locations.size()) {
+        return;
+    }
+    std::string entries;
+    ByteWriter writer(entries);
+    for (size_t i = indexedCount; i < locations.size(); ++i) {
+        writer.writeU32(locations[i].segment);
+        writer.writeU64(locations[i].offset);
+        writer.writeU32(locations[i].length);
+    }
+    if (std::fwrite(entries.data(), 1, entries.size(), indexFile) != entries.size() || std::fflush(indexFile) != 0) {
+        throw std::runtime_error("Cannot write to " + indexPath());
+    }
+    if (fsyncPolicy != FsyncPolicy::NEVER && !Utils::syncFile(indexFile)) {
+        throw std::runtime_error("Cannot sync " + indexPath());
+    }
+    indexedCount = locations.size();
+}
+
+void BlockStore::sync() {
+    if (activeFile && fsyncPolicy != FsyncPolicy::NEVER && !Utils::syncFile(activeFile)) {
+        throw std::runtime_error("Cannot sync " + segmentPath(activeSegment));
+    }
+    if (indexFile) {
+        flushIndex();
+    }
+}
+
+Block BlockStore::readBlock(uint64_t height) const {
+    std::lock_guard<std::mutex> lock(readMutex);
+    if (height >= locations.size()) {
+        throw std::out_of_range("No block at height " + std::to_string(height) + ".");
+    }
+    const Location& location = locations[height];
+
+    if (segmentMaps.size() <= location.segment) {
+        segmentMaps.resize(location.segment + 1);
+    }
+    std::unique_ptr<MappedFile>& file = segmentMaps[location.segment];
+    if (!file) {
+        file = std::make_unique<MappedFile>();
+    }
+    if (file->size() < location.offset + 4 + location.length) {
+        file->open(segmentPath(location.segment)); // The active segment has grown since it was mapped
+    }
+    return Block::deserialize(file->view(location.offset + 4, location.length));
+}
+
+uint64_t BlockStore::getBlockCount() const {
+    std::lock_guard<std::mutex> lock(readMutex);
+    return locations.size();
+}
+
+const std::string& BlockStore::getDirectory() const {
+    return directory;
+}
+
+std::string BlockStore::segmentPath(uint32_t segment) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%08u.log", static_cast<unsigned>(segment));
+    return (fs::path(directory) / name).string();
+}
+
+std::string BlockStore::indexPath() const {
+    return (fs::path(directory) / "index.dat").string();
+}
+
+std::FILE* BlockStore::openForAppend(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path + " for appending.");
+    }
+    return file;
+}
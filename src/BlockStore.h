@@ -0,0 +1,67 @@
+#ifndef BLOCK_STORE_H
+#define BLOCK_STORE_H
+
+#include "Block.h"
+#include "Config.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+// Append-only block log on disk. Blocks are written as length-prefixed records into
+// segment files (segment-00000000.log, ...) that roll over at a size limit, and read back
+// through memory maps. A separate index file maps each height to its record and is
+// written in batches; on open, records past the last indexed one are found by scanning
+// and a torn or unlinked tail left by a crash is cut off.
+class BlockStore {
+public:
+    explicit BlockStore(const std::string& directory,
+                        size_t segmentBytes = Config::getBlockSegmentBytes(),
+                        FsyncPolicy fsyncPolicy = Config::getFsyncPolicy()); // Throws std::runtime_error
+    ~BlockStore();
+
+    BlockStore(const BlockStore&) = delete;
+    BlockStore& operator=(const BlockStore&) = delete;
+
+    void append(const Block& block);        // Block index must equal getBlockCount()
+    Block readBlock(uint64_t height) const; // Throws std::out_of_range for unknown heights
+    uint64_t getBlockCount() const;
+    void sync(); // Write pending index entries and force everything to disk
+
+    const std::string& getDirectory() const;
+
+private:
+    struct Location {
+        uint32_t segment;
+        uint64_t offset; // Start of the record, i.e. of its length prefix
+        uint32_t length; // Payload bytes after the prefix
+    };
+    static const size_t INDEX_ENTRY_SIZE = 4 + 8 + 4;
+
+    std::string directory;
+    size_t segmentBytes;
+    FsyncPolicy fsyncPolicy;
+
+    std::vector<Location> locations; // By height
+    size_t indexedCount;             // Entries already written to the index file
+
+    std::FILE* activeFile;
+    uint32_t activeSegment;
+    uint64_t activeSize;
+    std::FILE* indexFile;
+
+    mutable std::mutex readMutex;
+    mutable std::vector<std::unique_ptr<MappedFile>> segmentMaps;
+
+    void recover();
+    void rollSegment();
+    void flushIndex();
+    std::string segmentPath(uint32_t segment) const;
+    std::string indexPath() const;
+    static std::FILE* openForAppend(const std::string& path);
+};
+
+#endif
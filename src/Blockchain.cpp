@@ -1,19 +1,129 @@
 #include "Blockchain.h"
+#include "Logger.h"
+#include "Config.h"
+#include <algorithm>
 
-Blockchain::Blockchain() {
+Blockchain::Blockchain()
+    : cache(Config::getBlockCacheSize()), blockIndex(std::make_unique<HashIndex>()), transactionIndex(std::make_unique<HashIndex>()) {
     // Create the genesis block
-    Block genesisBlock(0, "0", {});
-    chain.push_back(genesisBlock);
+    latestBlock = std::make_shared<const Block>(0, Hash256(), std::vector<Transaction>{}); // Genesis points at the all-zero hash
+    chain.push_back(latestBlock);
+    indexBlock(*latestBlock, *blockIndex, *transactionIndex);
 }
 
-void Blockchain::addBlock(const Block& newBlock) {
-    if (isValidNewBlock(newBlock, getLatestBlock())) {
-        chain.push_back(newBlock);
+bool Blockchain::open(const std::string& directory) {
+    try {
+        auto opened = std::make_unique<BlockStore>(directory);
+        std::shared_ptr<const Block> tip = latestBlock;
+        if (opened->getBlockCount() == 0) {
+            for (const auto& block : chain) {
+                opened->append(*block);
+            }
+        } else if (opened->readBlock(0).getHash() != chain.front()->getHash()) {
+            LOG_WARN("Block store at " + directory + " holds a different chain. Not opened.");
+            return false;
+        } else {
+            tip = std::make_shared<const Block>(opened->readBlock(opened->getBlockCount() - 1));
+            LOG_INFO("Loaded " + std::to_string(opened->getBlockCount()) + " blocks from " + directory);
+        }
+
+        uint64_t blockCount = opened->getBlockCount();
+        auto openedBlocks = std::make_unique<HashIndex>(directory, "block-hashes", blockCount);
+        auto openedTransactions = std::make_unique<HashIndex>(directory, "transaction-hashes", blockCount);
+        uint64_t indexed = std::min(openedBlocks->getIndexedHeights(), openedTransactions->getIndexedHeights());
+        for (uint64_t height = indexed; height < blockCount; ++height) {
+            if (height + 1 == blockCount) {
+                indexBlock(*tip, *openedBlocks, *openedTransactions);
+            } else {
+                indexBlock(opened->readBlock(height), *openedBlocks, *openedTransactions);
+            }
+        }
+        if (indexed + 1 < blockCount) {
+            LOG_INFO("Indexed " + std::to_string(blockCount - indexed) + " blocks from " + directory);
+        }
+
+        latestBlock = tip;
+        chain.clear();
+        cache.clear();
+        store = std::move(opened);
+        blockIndex = std::move(openedBlocks);
+        transactionIndex = std::move(openedTransactions);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Cannot open block store at " + directory + ": " + e.what());
+        return false;
+    }
+}
+
+bool Blockchain::isPersistent() const {
+    return store != nullptr;
+}
+
+bool Blockchain::addBlock(const Block& newBlock) {
+    if (!isValidNewBlock(newBlock, getLatestBlock())) {
+        return false;
+    }
+
+    auto block = std::make_shared<const Block>(newBlock);
+    if (store) {
+        try {
+            store->append(*block);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Block " + std::to_string(newBlock.getIndex()) + " not stored: " + e.what());
+            return false;
+        }
+    } else {
+        chain.push_back(block);
     }
+    latestBlock = block;
+    indexBlock(*block, *blockIndex, *transactionIndex);
+    return true;
 }
 
 const Block& Blockchain::getLatestBlock() const {
-    return chain.back();
+    return *latestBlock;
+}
+
+std::shared_ptr<const Block> Blockchain::getBlock(int height) const {
+    if (height < 0 || height >= getChainLength()) {
+        return nullptr;
+    }
+    if (height == latestBlock->getIndex()) {
+        return latestBlock;
+    }
+    if (!store) {
+        return chain[height];
+    }
+
+    std::shared_ptr<const Block> block = cache.get(height);
+    if (!block) {
+        block = std::make_shared<const Block>(store->readBlock(static_cast<uint64_t>(height)));
+        cache.put(height, block);
+    }
+    return block;
+}
+
+std::shared_ptr<const Block> Blockchain::getBlockByHash(const Hash256& hash) const {
+    std::optional<HashIndex::Location> location = blockIndex->find(hash);
+    return location ? getBlock(location->height) : nullptr;
+}
+
+std::optional<TransactionLocation> Blockchain::findTransaction(const Hash256& transactionHash) const {
+    std::optional<HashIndex::Location> location = transactionIndex->find(transactionHash);
+    if (!location) {
+        return std::nullopt;
+    }
+    return TransactionLocation{location->height, location->position};
+}
+
+void Blockchain::indexBlock(const Block& block, HashIndex& blocks, HashIndex& transactions) {
+    blocks.add(block.getHash(), block.getIndex());
+    const std::vector<Transaction>& blockTransactions = block.getTransactions();
+    for (size_t position = 0; position < blockTransactions.size(); ++position) {
+        transactions.add(blockTransactions[position].getHash(), block.getIndex(), static_cast<uint32_t>(position));
+    }
+    blocks.endHeight(block.getIndex());
+    transactions.endHeight(block.getIndex());
 }
 
 bool Blockchain::isValidNewBlock(const Block& newBlock, const Block& previousBlock) const {
@@ -27,5 +137,5 @@ bool Blockchain::isValidNewBlock(const Block& newBlock, const Block& previousBlo
 }
 
 int Blockchain::getChainLength() const {
-    return static_cast<int>(chain.size());
+    return store ? static_cast<int>(store->getBlockCount()) : static_cast<int>(chain.size());
 }
@@ -4,19 +4,49 @@
 #define BLOCKCHAIN_H
 
 #include "Block.h"
+#include "BlockStore.h"
+#include "BlockCache.h"
+#include "HashIndex.h"
 #include <vector>
+#include <optional>
+#include <memory>
+#include <string>
+
+// Where a committed transaction ended up
+struct TransactionLocation {
+    int height;
+    size_t position; // Index within the block's transaction list
+};
 
 class Blockchain {
 public:
     Blockchain();
 
-    void addBlock(const Block& newBlock);
+    // Persist the chain under directory from now on. An existing store there replaces the
+    // in-memory chain; an empty one receives it. False (and nothing changes) on failure.
+    bool open(const std::string& directory);
+    bool isPersistent() const;
+
+    bool addBlock(const Block& newBlock); // False if the block does not extend the chain
     const Block& getLatestBlock() const;
+    std::shared_ptr<const Block> getBlock(int height) const; // Null for heights not in the chain
+    std::shared_ptr<const Block> getBlockByHash(const Hash256& hash) const;
+    std::optional<TransactionLocation> findTransaction(const Hash256& transactionHash) const;
 
     int getChainLength() const;
 
 private:
-    std::vector<Block> chain;
+    std::vector<std::shared_ptr<const Block>> chain; // Only used while the chain lives in memory
+    std::unique_ptr<BlockStore> store;
+    std::shared_ptr<const Block> latestBlock;
+    mutable BlockCache cache; // Decoded blocks read back from the store
+
+    // Maintained on every addBlock and persisted next to the store; opening one only indexes the
+    // blocks its indexes had not written out yet
+    std::unique_ptr<HashIndex> blockIndex;
+    std::unique_ptr<HashIndex> transactionIndex;
+
+    static void indexBlock(const Block& block, HashIndex& blocks, HashIndex& transactions);
 
     bool isValidNewBlock(const Block& newBlock, const Block& previousBlock) const;
 };
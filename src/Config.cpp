@@ -7,3 +7,59 @@ int Config::getNodeCount() {
 int Config::getTimeout() {
     return TIMEOUT;
 }
+
+int Config::getTimeoutDelta() {
+    return TIMEOUT_DELTA;
+}
+
+size_t Config::getMaxBlockTransactions() {
+    return MAX_BLOCK_TRANSACTIONS;
+}
+
+size_t Config::getMaxBlockBytes() {
+    return MAX_BLOCK_BYTES;
+}
+
+size_t Config::getMempoolCapacity() {
+    return MEMPOOL_CAPACITY;
+}
+
+std::string Config::getDataDirectory() {
+    return "data";
+}
+
+size_t Config::getBlockSegmentBytes() {
+    return BLOCK_SEGMENT_BYTES;
+}
+
+FsyncPolicy Config::getFsyncPolicy() {
+    return FsyncPolicy::EVERY_BLOCK;
+}
+
+size_t Config::getIndexFlushInterval() {
+    return INDEX_FLUSH_INTERVAL;
+}
+
+size_t Config::getBlockCacheSize() {
+    return BLOCK_CACHE_SIZE;
+}
+
+int Config::getSnapshotInterval() {
+    return SNAPSHOT_INTERVAL;
+}
+
+uint64_t Config::getDefaultVotingPower() {
+    return DEFAULT_VOTING_POWER;
+}
+
+size_t Config::getValidatorHistory() {
+    return VALIDATOR_HISTORY;
+}
+
+bool Config::isPipelinedExecution() {
+    return PIPELINED_EXECUTION;
+}
+
+size_t Config::getLogBufferSize() {
+    return LOG_BUFFER_SIZE;
+}
@@ -3,14 +3,51 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// When the block store forces appended data to disk
+enum class FsyncPolicy {
+    NEVER,        // Leave it to the OS; a crash can lose recent blocks
+    EVERY_BLOCK,  // Each committed block is durable before addBlock returns
+    EVERY_SEGMENT // Sync when a segment file is sealed and on close
+};
+
 class Config {
 public:
     static int getNodeCount();
-    static int getTimeout();
+    static int getTimeout();      // Base for the propose, prevote and precommit timeouts
+    static int getTimeoutDelta(); // Added to every timeout for each round a height has failed
+    static size_t getMaxBlockTransactions();
+    static size_t getMaxBlockBytes();
+    static size_t getMempoolCapacity();
+    static std::string getDataDirectory();
+    static size_t getBlockSegmentBytes();
+    static FsyncPolicy getFsyncPolicy();
+    static size_t getIndexFlushInterval();
+    static size_t getBlockCacheSize();
+    static int getSnapshotInterval();
+    static uint64_t getDefaultVotingPower();
+    static size_t getValidatorHistory();
+    static bool isPipelinedExecution(); // Default for Network::setPipelinedExecution
+    static size_t getLogBufferSize();
 
 private:
     static const int NODE_COUNT = 4;
-    static const int TIMEOUT = 1000; // mm
+    static const int TIMEOUT = 1000; // ms, virtual time when the network runs in simulated mode
+    static const int TIMEOUT_DELTA = 500; // ms, later rounds wait longer so slow networks still converge
+    static const size_t MAX_BLOCK_TRANSACTIONS = 10000;
+    static const size_t MAX_BLOCK_BYTES = 1024 * 1024; // 1 MiB of encoded transactions
+    static const size_t MEMPOOL_CAPACITY = 100000;
+    static const size_t BLOCK_SEGMENT_BYTES = 64 * 1024 * 1024; // Block log rolls over to a new file past this
+    static const size_t INDEX_FLUSH_INTERVAL = 64; // Blocks appended between writes of the height and hash indexes
+    static const size_t BLOCK_CACHE_SIZE = 256; // Decoded blocks a persistent chain keeps in memory
+    static const int SNAPSHOT_INTERVAL = 100; // Heights between state snapshots on disk
+    static const uint64_t DEFAULT_VOTING_POWER = 1; // Power a node gets when it joins the network
+    static const size_t VALIDATOR_HISTORY = 1024; // Heights of validator sets kept for nodes that lag behind
+    static const bool PIPELINED_EXECUTION = false; // Apply decided blocks off the consensus thread
+    static const size_t LOG_BUFFER_SIZE = 65536; // Records the logger queues for its writer before dropping
 };
 
 #endif
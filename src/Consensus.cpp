@@ -1,198 +1,741 @@
 #include "Consensus.h"
 #include "Node.h"
-#include "Utils.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Config.h"
+#include "Serialization.h"
 #include <iostream>
-#include <chrono>
-#include <thread>
+#include <algorithm>
 
-// Define MAX_RETRIES if not already defined
+// Rounds a height may take before this node stops retrying it; a simulated run with no
+// quorum in reach still drains. Round numbers in messages are capped the same way.
 #ifndef MAX_RETRIES
 #define MAX_RETRIES 5
 #endif
 
+namespace {
+
+// Index into pendingTimers and the single payload byte of a TIMEOUT message
+size_t timerIndex(ConsensusStage step) {
+    switch (step) {
+        case ConsensusStage::PREVOTE:
+            return 1;
+        case ConsensusStage::PRECOMMIT:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+const Hash256 NIL_VOTE; // The zero hash
+
+// Stage latencies are in network time: virtual ms in a simulated run, real ms on a wall clock
+struct ConsensusMetrics {
+    Histogram& proposalToPrevote = Metrics::histogram("consensus_proposal_to_prevote_ms", "From entering a round to prevoting in it");
+    Histogram& prevoteToPrecommit = Metrics::histogram("consensus_prevote_to_precommit_ms", "From prevoting to precommitting in a round");
+    Histogram& precommitToCommit = Metrics::histogram("consensus_precommit_to_commit_ms", "From precommitting to deciding the block");
+    Histogram& heightCommit = Metrics::histogram("consensus_height_commit_ms", "From entering round 0 of a height to deciding it");
+    Counter& rounds = Metrics::counter("consensus_rounds_total", "Rounds entered");
+    Counter& commits = Metrics::counter("consensus_blocks_committed_total", "Blocks decided");
+    std::array<Counter*, 3> timeouts = {&Metrics::counter("consensus_timeouts_total{step=\"propose\"}", "Step timeouts that fired"),
+                                        &Metrics::counter("consensus_timeouts_total{step=\"prevote\"}", "Step timeouts that fired"),
+                                        &Metrics::counter("consensus_timeouts_total{step=\"precommit\"}", "Step timeouts that fired")};
+};
+
+ConsensusMetrics& consensusMetrics() {
+    static ConsensusMetrics metrics;
+    return metrics;
+}
+
+// Block h carries the state root after block h - APP_HASH_LAG. Two heights back rather than one,
+// so a node can propose and vote on h while block h - 1 is still being applied.
+const uint64_t APP_HASH_LAG = 2;
+
+} // namespace
+
 Consensus::Consensus(Node* node, StateMachine* stateMachine)
     : node(node),
       stateMachine(stateMachine),
       currentStage(ConsensusStage::PROPOSAL),
-      proposalBlockIndex(0),
-      currentLeaderId(-1),
-      retryCount(0),
-      threshold(0) { // Default threshold is 0, dynamically calculated
+      round(0),
+      roundActive(false),
+      validatorsHeight(0),
+      lockedRound(-1),
+      validRound(-1),
+      pendingTimers{},
+      heightStartMs(0),
+      roundStartMs(0),
+      prevoteSentMs(-1),
+      precommitSentMs(-1),
+      walFailed(false) {
 }
 
-void Consensus::startConsensus() {
-    try {
-        size_t totalNodes = node->getNetwork()->getTotalNodes();
-        threshold = (2 * totalNodes) / 3 + 1; // Calculate 2/3 majority dynamically
-        Utils::log("Threshold for consensus set to " + std::to_string(threshold) + " out of " + std::to_string(totalNodes) + " nodes.");
+uint64_t Consensus::getHeight() const {
+    return static_cast<uint64_t>(getDecidedTip().getIndex()) + 1;
+}
+
+const Block& Consensus::getDecidedTip() const {
+    // The chain is only read once the executor is done with it, never while it is appending
+    return executingBlock ? *executingBlock : node->getBlockchain().getLatestBlock();
+}
+
+std::optional<Hash256> Consensus::expectedAppHash(uint64_t height) const {
+    if (height <= APP_HASH_LAG) {
+        return Hash256(); // Nothing executed that far back
+    }
+    return node->getExecutor().getAppHash(height - APP_HASH_LAG);
+}
+
+uint32_t Consensus::getRound() const {
+    return round;
+}
 
-        // Always re-fetch transactions from Node
-        pendingTransactions = node->getPendingTransactions();
+void Consensus::reportEquivocation(int nodeId) {
+    if (byzantineNodes.insert(static_cast<size_t>(nodeId)).second) {
+        LOG_WARN("Node " + std::to_string(nodeId) + " equivocated and is ignored from now on.");
+    }
+}
 
-        if (!pendingTransactions.empty()) {
-            initiateProposal();
+void Consensus::startConsensus() {
+    try {
+        Network* network = node->getNetwork();
+        if (roundActive) {
+            LOG_INFO("Node " + std::to_string(node->getId()) + " is already in round " + std::to_string(round) +
+                       " of height " + std::to_string(getHeight()) + ".");
+        } else if (network && network->hasPendingTransactions()) {
+            enterRound(round);
         } else {
-            Utils::log("No transactions available for consensus. Waiting...");
+            LOG_INFO("No transactions available for consensus. Waiting...");
         }
+        syncWal();
     } catch (const std::exception& e) {
-        Utils::log("Exception in startConsensus: " + std::string(e.what()));
+        LOG_ERROR("Exception in startConsensus: " + std::string(e.what()));
     }
 }
 
-void Consensus::onReceiveMessage(const Message& message) {
-    switch (message.getType()) {
-        case PROPOSAL:
-            handleProposal(message);
-            break;
-        case PREVOTE:
-            handlePrevote(message);
-            break;
-        case PRECOMMIT:
-            handlePrecommit(message);
-            break;
-        default:
-            Utils::log("Unknown message type received by Consensus");
+void Consensus::loadValidators() {
+    validators = node->getNetwork()->getValidatorSet(getHeight());
+    validatorsHeight = validators.empty() ? 0 : getHeight(); // Nobody registered yet, try again on the next message
+    roundProposers.clear();
+    LOG_DEBUG("Validator set for height " + std::to_string(getHeight()) + ": " + std::to_string(validators.size()) +
+               " validators, quorum " + std::to_string(validators.getQuorumPower()) + " of " +
+               std::to_string(validators.getTotalPower()) + " voting power.");
+
+    // Rounds restored from the WAL before the node joined have vote sets sized for no validators.
+    // Rebuild them; only our own votes and proposals carry over.
+    for (auto& entry : rounds) {
+        RoundState& state = entry.second;
+        state.prevotes.reset(getHeight(), entry.first, PREVOTE, validators.size(), validators.getQuorumPower());
+        state.precommits.reset(getHeight(), entry.first, PRECOMMIT, validators.size(), validators.getQuorumPower());
+        state.senders.reset(validators.size());
+        state.senderPower = 0;
+        for (const std::optional<Message>& own : {state.ownPrevote, state.ownPrecommit}) {
+            if (own) {
+                recordVote(*own);
+            }
+        }
+        if (state.proposalMessage) {
+            markSender(state, state.proposalMessage->getSenderId());
+        }
     }
 }
 
-void Consensus::initiateProposal() {
-    electNewLeader();
-    if (node->getId() == currentLeaderId) {
-        Utils::log("Node " + std::to_string(node->getId()) + " is the leader. Proposing a new block.");
-        Utils::log("Transactions in Node (before proposal): " + std::to_string(node->getPendingTransactions().size()));
+void Consensus::markSender(RoundState& state, int senderId) {
+    size_t index = validators.getIndex(senderId);
+    if (index != ValidatorSet::NO_INDEX && state.senders.set(index)) {
+        state.senderPower += validators.getValidator(index).votingPower;
+    }
+}
 
-        proposalHash = "Block_" + std::to_string(proposalBlockIndex++);
-        pendingTransactions = node->getPendingTransactions(); // Transfer transactions
-        Utils::log("Transactions being proposed (Consensus): " + std::to_string(pendingTransactions.size()));
+Consensus::RoundState& Consensus::roundState(uint32_t forRound) {
+    auto inserted = rounds.try_emplace(forRound);
+    RoundState& state = inserted.first->second;
+    if (inserted.second) {
+        state.prevotes.reset(getHeight(), forRound, PREVOTE, validators.size(), validators.getQuorumPower());
+        state.precommits.reset(getHeight(), forRound, PRECOMMIT, validators.size(), validators.getQuorumPower());
+        state.senders.reset(validators.size());
+    }
+    return state;
+}
 
-        if (stateMachine) {
-            stateMachine->createSnapshot();
-        }
+int Consensus::getProposerId(uint32_t forRound) {
+    // Round 0 goes to the height's proposer; each failed round advances the rotation one more step
+    if (roundProposers.empty()) {
+        proposerRotation = validators;
+        roundProposers.push_back(validators.getProposer()->id);
+    }
+    while (roundProposers.size() <= forRound) {
+        proposerRotation.incrementProposerPriority(1);
+        roundProposers.push_back(proposerRotation.getProposer()->id);
+    }
+    return roundProposers[forRound];
+}
 
-        broadcastMessage(MessageType::PROPOSAL, proposalHash);
-        currentStage = ConsensusStage::PREVOTE;
+void Consensus::onReceiveMessage(const Message& message) {
+    handleMessage(message);
+
+    // Everything this message made us log hits the disk in one flush, before any reply is delivered
+    syncWal();
+}
+
+void Consensus::handleMessage(const Message& message) {
+    if (message.getType() == TIMEOUT) {
+        handleTimeout(message);
+        return;
+    }
+    if (message.getType() != PROPOSAL && message.getType() != PREVOTE && message.getType() != PRECOMMIT) {
+        LOG_WARN("Unknown message type received by Consensus");
+        return;
+    }
+
+    uint64_t height = getHeight();
+    if (message.getHeight() > height) {
+        futureMessages.push_back(message); // Replayed once we commit the heights in between
+        return;
+    }
+    if (message.getHeight() < height || message.getRound() > round + MAX_RETRIES) {
+        return; // Already decided, or a round no honest node reaches
+    }
+    if (validatorsHeight != height) {
+        loadValidators();
+    }
+    if (validators.empty()) {
+        return; // No validator set to check proposers and quorums against
+    }
+    if (!validators.contains(message.getSenderId())) {
+        LOG_DEBUG("Message from unknown Node " + std::to_string(message.getSenderId()) + " ignored.");
+        return;
+    }
+    if (byzantineNodes.count(message.getSenderId())) {
+        LOG_DEBUG("Message from Byzantine Node " + std::to_string(message.getSenderId()) + " ignored.");
+        return;
+    }
+
+    if (message.getType() == PROPOSAL) {
+        handleProposal(message);
     } else {
-        Utils::log("Node " + std::to_string(node->getId()) + " is waiting for proposal from leader.");
+        handleVote(message);
+    }
+
+    if (!roundActive) {
+        // Someone started this height without us; join in at our round and let the messages catch us up
+        enterRound(round);
+    } else {
+        evaluate();
     }
 }
 
-void Consensus::broadcastMessage(MessageType type, const std::string& content) {
-    if (node) {
-        Message message(type, node->getId(), content);
-        node->sendMessageToAll(message);
+void Consensus::enterRound(uint32_t newRound) {
+    if (validatorsHeight != getHeight()) {
+        loadValidators();
+    }
+    if (validators.empty()) {
+        LOG_WARN("No validator set for height " + std::to_string(getHeight()) + ". Consensus cannot start.");
+        return;
     }
+    cancelTimeouts();
+    roundStartMs = node->getNetwork()->getCurrentTimeMs();
+    if (newRound == 0) {
+        heightStartMs = roundStartMs;
+    }
+    prevoteSentMs = precommitSentMs = -1;
+    consensusMetrics().rounds.increment();
+    round = newRound;
+    roundActive = true;
+    currentStage = ConsensusStage::PROPOSAL;
+    LOG_DEBUG("Node " + std::to_string(node->getId()) + " entered round " + std::to_string(round) +
+               " of height " + std::to_string(getHeight()) + ".");
+
+    if (getProposerId(round) == node->getId()) {
+        propose();
+    } else {
+        LOG_DEBUG("Node " + std::to_string(node->getId()) + " is waiting for proposal from Node " + std::to_string(getProposerId(round)) + ".");
+        scheduleTimeout(ConsensusStage::PROPOSAL);
+    }
+    evaluate();
 }
 
-void Consensus::handleProposal(const Message& message) {
-    Utils::log("Node " + std::to_string(node->getId()) + " received proposal from Node " + std::to_string(message.getSenderId()) + ": " + message.getContent());
+void Consensus::propose() {
+    if (walFailed) {
+        return;
+    }
+    RoundState& state = roundState(round);
+    if (state.proposalMessage) {
+        // Already signed a proposal for this height and round, e.g. before a restart; never sign a second one
+        LOG_DEBUG("Node " + std::to_string(node->getId()) + " is the proposer. Re-sending its proposal for block " +
+                   std::to_string(state.proposal->getIndex()) + ".");
+        send(*state.proposalMessage);
+        return;
+    }
+
+    std::shared_ptr<const Block> block = validBlock;
+    if (block) {
+        LOG_DEBUG("Node " + std::to_string(node->getId()) + " is the proposer. Re-proposing the valid block from round " +
+                   std::to_string(validRound) + ".");
+    } else {
+        LOG_DEBUG("Node " + std::to_string(node->getId()) + " is the proposer. Proposing a new block.");
+        Mempool& mempool = node->getNetwork()->getMempool();
+        LOG_DEBUG("Transactions in mempool (before proposal): " + std::to_string(mempool.size()));
+
+        std::vector<Transaction> batch = mempool.reapBatch(Config::getMaxBlockTransactions(), Config::getMaxBlockBytes());
+        LOG_DEBUG("Transactions being proposed (Consensus): " + std::to_string(batch.size()));
 
-    currentStage = ConsensusStage::PREVOTE;
-    proposalHash = message.getContent();
+        const Block& latestBlock = getDecidedTip();
+        block = std::make_shared<const Block>(latestBlock.getIndex() + 1, latestBlock.getHash(), batch,
+                                              expectedAppHash(getHeight()).value_or(Hash256()));
+        if (stateMachine) {
+            stateMachine->createSnapshot();
+        }
+    }
 
-    broadcastMessage(MessageType::PREVOTE, proposalHash);
+    // Serialize once; every recipient's copy of the message shares this buffer
+    auto payload = std::make_shared<std::string>();
+    ByteWriter writer(*payload);
+    writer.writeI32(validBlock ? validRound : -1);
+    block->serialize(*payload);
+    Message proposal(MessageType::PROPOSAL, node->getId(), getHeight(), round, block->getHash(), std::move(payload));
+    node->signMessage(proposal);
+
+    state.proposal = block;
+    state.proposalValidRound = validBlock ? validRound : -1;
+    state.proposalMessage = proposal;
+    markSender(state, node->getId());
+    logToWal(WalEntryType::PROPOSAL, proposal.encode());
+    send(proposal);
 }
 
-void Consensus::handlePrevote(const Message& message) {
-    Utils::log("Node " + std::to_string(node->getId()) + " received prevote from Node " + std::to_string(message.getSenderId()));
+void Consensus::handleProposal(const Message& message) {
+    LOG_DEBUG("Node " + std::to_string(node->getId()) + " received proposal from Node " + std::to_string(message.getSenderId()));
 
-    if (byzantineNodes.count(message.getSenderId())) {
-        Utils::log("Prevote from Byzantine Node " + std::to_string(message.getSenderId()) + " ignored.");
+    if (message.getSenderId() != getProposerId(message.getRound())) {
+        LOG_DEBUG("Proposal from Node " + std::to_string(message.getSenderId()) + ", which is not the proposer of round " +
+                   std::to_string(message.getRound()) + ". Ignored.");
         return;
     }
+    RoundState& state = roundState(message.getRound());
+    markSender(state, message.getSenderId());
+    if (state.proposal) {
+        return; // Proposer re-sent its proposal, or signed a second one we will not look at
+    }
 
-    prevotesReceived.insert(message.getSenderId());
+    std::shared_ptr<const Block> block;
+    int32_t proposalValidRound;
+    try {
+        ByteReader reader(message.getPayload());
+        proposalValidRound = reader.readI32();
+        block = std::make_shared<const Block>(Block::deserialize(message.getPayload().substr(reader.getPosition())));
+    } catch (const std::exception& e) {
+        LOG_WARN("Malformed proposal ignored: " + std::string(e.what()));
+        return;
+    }
+    if (block->getHash() != message.getBlockHash()) {
+        LOG_WARN("Proposal whose block does not match its hash ignored.");
+        return;
+    }
+    const Block& latestBlock = getDecidedTip();
+    if (static_cast<uint64_t>(block->getIndex()) != message.getHeight() || block->getPreviousHash() != latestBlock.getHash()) {
+        LOG_DEBUG("Proposal for block " + std::to_string(block->getIndex()) + " does not extend our chain. Ignored.");
+        return;
+    }
+    std::optional<Hash256> appHash = expectedAppHash(message.getHeight());
+    if (appHash && block->getAppHash() != *appHash) {
+        LOG_WARN("Proposal for block " + std::to_string(block->getIndex()) + " disagrees with our state root. Ignored.");
+        return;
+    }
+    if (proposalValidRound < -1 || proposalValidRound >= static_cast<int32_t>(message.getRound())) {
+        LOG_WARN("Proposal with an impossible valid round ignored.");
+        return;
+    }
 
-    if (isQuorumReached(prevotesReceived, threshold)) {
-        Utils::log("Quorum reached for PREVOTE. Broadcasting PRECOMMIT.");
-        currentStage = ConsensusStage::PRECOMMIT;
-        broadcastMessage(MessageType::PRECOMMIT, proposalHash);
-    } else {
-        checkForTimeout();
+    state.proposal = block;
+    state.proposalValidRound = proposalValidRound;
+    state.proposalMessage = message;
+    logToWal(WalEntryType::PROPOSAL, message.encode());
+}
+
+void Consensus::handleVote(const Message& message) {
+    LOG_TRACE("Node " + std::to_string(node->getId()) + " received " + (message.getType() == PREVOTE ? "prevote" : "precommit") +
+               " from Node " + std::to_string(message.getSenderId()));
+    if (!recordVote(message)) {
+        LOG_DEBUG("Second vote from Node " + std::to_string(message.getSenderId()) + " in round " + std::to_string(message.getRound()) + " ignored.");
     }
 }
 
-void Consensus::handlePrecommit(const Message& message) {
-    Utils::log("Node " + std::to_string(node->getId()) + " received precommit from Node " + std::to_string(message.getSenderId()));
+bool Consensus::recordVote(const Message& vote) {
+    size_t voter = validators.getIndex(vote.getSenderId());
+    if (voter == ValidatorSet::NO_INDEX) {
+        return false;
+    }
+    RoundState& state = roundState(vote.getRound());
+    markSender(state, vote.getSenderId());
+    VoteSet& votes = vote.getType() == PREVOTE ? state.prevotes : state.precommits;
+    return votes.addVote(voter, vote.getBlockHash(), validators.getValidator(voter).votingPower);
+}
 
-    if (byzantineNodes.count(message.getSenderId())) {
-        Utils::log("Precommit from Byzantine Node " + std::to_string(message.getSenderId()) + " ignored.");
+void Consensus::castVote(MessageType type, const Hash256& blockHash) {
+    if (walFailed) {
         return;
     }
+    RoundState& state = roundState(round);
+    std::optional<Message>& own = type == PREVOTE ? state.ownPrevote : state.ownPrecommit;
+    if (!own) {
+        own = Message(type, node->getId(), getHeight(), round, blockHash);
+        node->signMessage(*own);
+        long long nowMs = node->getNetwork()->getCurrentTimeMs();
+        if (type == PREVOTE) {
+            consensusMetrics().proposalToPrevote.record(static_cast<uint64_t>(nowMs - roundStartMs));
+            prevoteSentMs = nowMs;
+        } else {
+            if (prevoteSentMs >= 0) {
+                consensusMetrics().prevoteToPrecommit.record(static_cast<uint64_t>(nowMs - prevoteSentMs));
+            }
+            precommitSentMs = nowMs;
+        }
+        recordVote(*own);
+        logToWal(WalEntryType::VOTE, own->encode());
+    }
+    // A vote recorded before a restart is re-sent as is, even if we would vote differently now
+    send(*own);
+    currentStage = type == PREVOTE ? ConsensusStage::PREVOTE : ConsensusStage::PRECOMMIT;
+}
 
-    precommitsReceived.insert(message.getSenderId());
+void Consensus::evaluate() {
+    if (!roundActive) {
+        return;
+    }
+    RoundState& state = roundState(round);
+    Hash256 proposalHash = state.proposal ? state.proposal->getHash() : NIL_VOTE;
+
+    // Prevote the proposal unless we are locked on something else that it gives no reason to drop
+    if (currentStage == ConsensusStage::PROPOSAL && state.proposal) {
+        int32_t vr = state.proposalValidRound;
+        bool lockedOnIt = lockedBlock && lockedBlock->getHash() == proposalHash;
+        if (vr == -1) {
+            castVote(PREVOTE, (lockedRound == -1 || lockedOnIt) ? proposalHash : NIL_VOTE);
+        } else if (roundState(static_cast<uint32_t>(vr)).prevotes.hasQuorum(proposalHash)) {
+            castVote(PREVOTE, (lockedRound <= vr || lockedOnIt) ? proposalHash : NIL_VOTE);
+        }
+        // Otherwise wait for the polka it refers to, or the propose timeout
+    }
 
-    if (isQuorumReached(precommitsReceived, threshold)) {
-        Utils::log("Quorum reached for PRECOMMIT. Finalizing consensus.");
-        finalizeConsensus();
-    } else {
-        checkForTimeout();
+    if (currentStage == ConsensusStage::PREVOTE && !state.prevoteWaitArmed && state.prevotes.hasQuorumAny()) {
+        state.prevoteWaitArmed = true;
+        scheduleTimeout(ConsensusStage::PREVOTE);
+    }
+
+    if (state.proposal && !state.polkaSeen && currentStage != ConsensusStage::PROPOSAL &&
+        state.prevotes.hasQuorum(proposalHash)) {
+        state.polkaSeen = true;
+        if (currentStage == ConsensusStage::PREVOTE) {
+            LOG_DEBUG("Quorum reached for PREVOTE. Locking block " + std::to_string(state.proposal->getIndex()) + " and broadcasting PRECOMMIT.");
+            lockedBlock = state.proposal;
+            lockedRound = static_cast<int32_t>(round);
+            castVote(PRECOMMIT, proposalHash);
+        }
+        validBlock = state.proposal;
+        validRound = static_cast<int32_t>(round);
+    }
+
+    if (currentStage == ConsensusStage::PREVOTE && state.prevotes.hasQuorum(NIL_VOTE)) {
+        LOG_DEBUG("Quorum of nil prevotes. Broadcasting nil PRECOMMIT.");
+        castVote(PRECOMMIT, NIL_VOTE);
+    }
+
+    if (!state.precommitWaitArmed && state.precommits.hasQuorumAny()) {
+        state.precommitWaitArmed = true;
+        scheduleTimeout(ConsensusStage::PRECOMMIT);
+    }
+
+    // A block with a precommit quorum in any round is decided, even if we moved past that round
+    for (auto& entry : rounds) {
+        RoundState& candidate = entry.second;
+        std::optional<Hash256> decided = candidate.precommits.getMajority();
+        if (candidate.proposal && decided && *decided == candidate.proposal->getHash()) {
+            LOG_DEBUG("Quorum reached for PRECOMMIT in round " + std::to_string(entry.first) + ". Finalizing consensus.");
+            finalizeConsensus(candidate.proposal, *candidate.proposalMessage);
+            return;
+        }
+    }
+
+    // More than a third of the power is already in a later round, so at least one honest node is; follow it there
+    uint64_t skipPower = validators.getTotalPower() - validators.getQuorumPower() + 1;
+    for (auto it = rounds.upper_bound(round); it != rounds.end(); ++it) {
+        if (it->second.senderPower >= skipPower) {
+            LOG_INFO("Node " + std::to_string(node->getId()) + " skipping to round " + std::to_string(it->first) + ".");
+            enterRound(it->first);
+            return;
+        }
     }
 }
 
-void Consensus::checkForTimeout() {
-    if (retryCount < MAX_RETRIES) {
-        retryCount++;
-        Utils::log("Retrying consensus, attempt " + std::to_string(retryCount));
+void Consensus::scheduleTimeout(ConsensusStage step) {
+    Network* network = node->getNetwork();
+    if (!network) {
+        return;
+    }
+    size_t index = timerIndex(step);
+    if (pendingTimers[index] != 0) {
+        network->cancelTimeout(pendingTimers[index]);
+    }
+    auto payload = std::make_shared<std::string>(1, static_cast<char>(index));
+    int delayMs = Config::getTimeout() + static_cast<int>(round) * Config::getTimeoutDelta();
+    pendingTimers[index] = network->scheduleTimeout(node, delayMs, Message(TIMEOUT, node->getId(), getHeight(), round, NIL_VOTE, std::move(payload)));
+}
 
-        // Retain pending transactions
-        if (pendingTransactions.empty() && !node->getPendingTransactions().empty()) {
-            pendingTransactions = node->getPendingTransactions();
-            Utils::log("Re-synchronized transactions during retry. Size: " + std::to_string(pendingTransactions.size()));
+void Consensus::cancelTimeouts() {
+    Network* network = node->getNetwork();
+    for (uint64_t& timer : pendingTimers) {
+        if (timer != 0 && network) {
+            network->cancelTimeout(timer);
         }
+        timer = 0;
+    }
+}
 
-        startConsensus();
-    } else {
-        Utils::log("Consensus failed after maximum retries. Exiting consensus loop.");
-        retryCount = 0;
-        rollbackConsensus();
+void Consensus::handleTimeout(const Message& message) {
+    std::string_view payload = message.getPayload();
+    if (payload.size() != 1 || static_cast<uint8_t>(payload[0]) >= pendingTimers.size()) {
+        return;
+    }
+    size_t index = static_cast<uint8_t>(payload[0]);
+    pendingTimers[index] = 0;
+    consensusMetrics().timeouts[index]->increment();
+
+    // Timers are cancelled when the round moves on, so a stale one only slips through a restart
+    if (!roundActive || message.getHeight() != getHeight() || message.getRound() != round) {
+        return;
+    }
+
+    if (index == timerIndex(ConsensusStage::PROPOSAL) && currentStage == ConsensusStage::PROPOSAL) {
+        LOG_INFO("No acceptable proposal in round " + std::to_string(round) + ". Prevoting nil.");
+        castVote(PREVOTE, NIL_VOTE);
+        evaluate();
+    } else if (index == timerIndex(ConsensusStage::PREVOTE) && currentStage == ConsensusStage::PREVOTE) {
+        LOG_INFO("Prevotes split in round " + std::to_string(round) + ". Precommitting nil.");
+        castVote(PRECOMMIT, NIL_VOTE);
+        evaluate();
+    } else if (index == timerIndex(ConsensusStage::PRECOMMIT)) {
+        if (round + 1 > MAX_RETRIES) {
+            LOG_WARN("Consensus failed after maximum rounds. Waiting for new messages.");
+            cancelTimeouts();
+            roundActive = false;
+            return;
+        }
+        LOG_INFO("Retrying consensus, round " + std::to_string(round + 1));
+        enterRound(round + 1);
     }
 }
 
-void Consensus::waitForNewTransactions() {
-    while (node->getPendingTransactions().empty()) {
-        Utils::log("No new transactions. Waiting...");
-        std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Check every 500ms
+void Consensus::finalizeConsensus(std::shared_ptr<const Block> block, const Message& proposal) {
+    LOG_DEBUG("Consensus finalized for block " + std::to_string(block->getIndex()) + ": " + block->getHash().toHex());
+    currentStage = ConsensusStage::FINALIZED;
+
+    // The decision is durable before the block is, so a crash in between still commits it on restart
+    std::string decision;
+    if (wal) {
+        ByteWriter writer(decision);
+        writer.writeU64(static_cast<uint64_t>(block->getIndex()));
+        writer.writeBytes(block->getHash().data(), Hash256::SIZE);
+        logToWal(WalEntryType::COMMIT, decision);
+        syncWal();
+    }
+    node->getNetwork()->getMempool().removeCommitted(block->getTransactions()); // Before anyone reaps the next block
+
+    // At most one block is in flight: the one before this is stored and its state root known
+    // before this one goes to the executor
+    if (executingBlock) {
+        node->waitForExecution();
+        executingBlock.reset();
+    }
+    bool pipelined = node->getNetwork()->isPipelinedExecution();
+    bool committed = true;
+    if (pipelined) {
+        executingBlock = block;
+        node->getExecutor().submit(block);
+    } else {
+        committed = node->getExecutor().execute(*block);
+    }
+    if (committed) {
+        long long nowMs = node->getNetwork()->getCurrentTimeMs();
+        long long latencyMs = nowMs - heightStartMs;
+        ConsensusMetrics& metrics = consensusMetrics();
+        if (precommitSentMs >= 0) {
+            metrics.precommitToCommit.record(static_cast<uint64_t>(nowMs - precommitSentMs));
+        }
+        metrics.heightCommit.record(static_cast<uint64_t>(latencyMs));
+        metrics.commits.increment();
+        LOG_INFO("Node " + std::to_string(node->getId()) + " committed block " + std::to_string(block->getIndex()) +
+                   " in round " + std::to_string(round) + " with " + std::to_string(block->getTransactions().size()) +
+                   " transactions in " + std::to_string(latencyMs) + " ms.");
+    }
+    if (wal) {
+        wal->reset(); // The block store has every earlier height now; nothing before this point needs replaying
+        if (pipelined) {
+            // This block may not be stored yet; keep what replaying its decision takes
+            logToWal(WalEntryType::PROPOSAL, proposal.encode());
+            logToWal(WalEntryType::COMMIT, decision);
+            syncWal();
+        }
+    }
+    resetHeight();
+
+    if (node->getNetwork()->hasPendingTransactions()) {
+        LOG_DEBUG("Ready for the next round of consensus.");
+        enterRound(0);
     }
 
-    Utils::log("New transactions detected. Resuming consensus.");
-    pendingTransactions = node->getPendingTransactions(); // Retrieve transactions
-    startConsensus(); // Restart consensus with new transactions
+    // Messages for the next height may have arrived while we were still committing this one
+    std::vector<Message> buffered;
+    buffered.swap(futureMessages);
+    for (const Message& message : buffered) {
+        handleMessage(message);
+    }
 }
 
-void Consensus::finalizeConsensus() {
-    Utils::log("Consensus finalized for block: " + proposalHash);
+void Consensus::resetHeight() {
+    cancelTimeouts();
+    rounds.clear();
+    round = 0;
+    roundActive = false;
+    lockedBlock.reset();
+    lockedRound = -1;
+    validBlock.reset();
+    validRound = -1;
+}
 
-    if (!pendingTransactions.empty()) {
-        Utils::log("Transactions before processing (Consensus): " + std::to_string(pendingTransactions.size()));
-        stateMachine->prepareState(pendingTransactions);
-        stateMachine->commitState();
-        stateMachine->printState();
+bool Consensus::recover(const std::string& walPath) {
+    try {
+        wal = std::make_unique<WriteAheadLog>(walPath);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Cannot open consensus WAL " + walPath + ": " + e.what());
+        return false;
+    }
 
-        pendingTransactions.clear();
-        node->clearPendingTransactions();
+    // The log only holds what happened since the last committed height, so this is a short walk
+    try {
+        for (const WalEntry& entry : wal->getRecoveredEntries()) {
+            uint64_t height = getHeight();
+            if (entry.type == WalEntryType::COMMIT) {
+                ByteReader reader(entry.data);
+                uint64_t decidedHeight = reader.readU64();
+                Hash256 hash = Hash256::fromBytes(reader.readBytes(Hash256::SIZE).data());
+                if (decidedHeight != height) {
+                    continue;
+                }
+                for (const auto& state : rounds) {
+                    if (state.second.proposal && state.second.proposal->getHash() == hash) {
+                        LOG_INFO("Committing block " + std::to_string(decidedHeight) + " decided before the restart.");
+                        std::shared_ptr<const Block> block = state.second.proposal;
+                        node->getExecutor().execute(*block);
+                        resetHeight();
+                        currentStage = ConsensusStage::FINALIZED;
+                        break;
+                    }
+                }
+                continue;
+            }
+
+            Message message = Message::decode(std::make_shared<const std::string>(entry.data));
+            if (message.getHeight() != height) {
+                continue; // Already committed
+            }
+            if (message.getRound() > round || rounds.empty()) {
+                round = message.getRound();
+                currentStage = ConsensusStage::PROPOSAL;
+            }
+            if (entry.type == WalEntryType::PROPOSAL) {
+                RoundState& state = roundState(message.getRound());
+                ByteReader reader(message.getPayload());
+                state.proposalValidRound = reader.readI32();
+                state.proposal = std::make_shared<const Block>(Block::deserialize(message.getPayload().substr(reader.getPosition())));
+                state.proposalMessage = message;
+            } else if (entry.type == WalEntryType::VOTE) {
+                // Only our own votes are logged; restore them so we never sign a conflicting one
+                RoundState& state = roundState(message.getRound());
+                recordVote(message);
+                bool prevote = message.getType() == PREVOTE;
+                (prevote ? state.ownPrevote : state.ownPrecommit) = message;
+                if (message.getRound() == round) {
+                    currentStage = prevote ? ConsensusStage::PREVOTE : ConsensusStage::PRECOMMIT;
+                }
+                if (!prevote && message.getBlockHash() != NIL_VOTE && state.proposal &&
+                    state.proposal->getHash() == message.getBlockHash()) {
+                    lockedBlock = validBlock = state.proposal;
+                    lockedRound = validRound = static_cast<int32_t>(message.getRound());
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN("Consensus WAL replay stopped early: " + std::string(e.what()));
+    }
+
+    roundActive = false; // Resumed by the next message for this height or by startConsensus
+    if (rounds.empty()) {
+        wal->reset(); // Nothing undecided left in it
     } else {
-        Utils::log("No transactions to process.");
+        LOG_INFO("Resumed height " + std::to_string(getHeight()) + " at round " + std::to_string(round) +
+                   " in stage " + getCurrentStageAsString() + " from the WAL.");
     }
+    return true;
+}
+
+void Consensus::logToWal(WalEntryType type, const std::string& data) {
+    if (wal) {
+        wal->append(type, data);
+    }
+}
 
-    Utils::log("Ready for the next round of consensus.");
-    startConsensus();
+void Consensus::send(const Message& message) {
+    if (wal) {
+        outbox.push_back(message); // Sent by syncWal once the WAL holds it
+    } else {
+        node->sendMessageToAll(message);
+    }
 }
 
+void Consensus::syncWal() {
+    if (!wal) {
+        return;
+    }
+    std::vector<Message> ready;
+    ready.swap(outbox);
+    if (walFailed) {
+        return;
+    }
+    try {
+        wal->sync();
+    } catch (const std::exception& e) {
+        // A restart would not know what we signed and could sign something conflicting, so stop signing
+        // altogether and never send what the WAL does not hold
+        LOG_ERROR("Consensus WAL sync failed: " + std::string(e.what()) + ". Node " + std::to_string(node->getId()) +
+                  " stops proposing and voting.");
+        walFailed = true;
+        cancelTimeouts();
+        roundActive = false;
+        return;
+    }
+    for (const Message& message : ready) {
+        node->sendMessageToAll(message);
+    }
+}
 
 void Consensus::rollbackConsensus() {
-    Utils::log("Consensus failed and state has been rolled back.");
+    LOG_INFO("Consensus failed and state has been rolled back.");
 
+    node->waitForExecution(); // Only the undecided proposal is rolled back, never a decided block
     if (stateMachine) {
         stateMachine->rollbackState();
     }
 
-    // Rebroadcast pending transactions
-    for (const auto& transaction : pendingTransactions) {
-        broadcastMessage(MessageType::PROPOSAL, transaction.toString());
+    // Nothing was committed, so the transactions are still in the mempool; give the height another round
+    if (roundActive && round < MAX_RETRIES) {
+        LOG_INFO("Restarting consensus after rollback in round " + std::to_string(round + 1) + "...");
+        enterRound(round + 1);
+        syncWal();
+    } else {
+        LOG_INFO("Restarting consensus after rollback...");
+        startConsensus();
     }
-
-    Utils::log("Restarting consensus after rollback...");
-    startConsensus();
 }
 
 std::string Consensus::getCurrentStageAsString() const {
@@ -209,17 +752,3 @@ std::string Consensus::getCurrentStageAsString() const {
             return "UNKNOWN";
     }
 }
-
-bool Consensus::isQuorumReached(const std::unordered_set<size_t>& votes, size_t quorumThreshold) {
-    return votes.size() >= quorumThreshold;
-}
-
-void Consensus::electNewLeader() {
-    currentLeaderId = (currentLeaderId + 1) % node->getNetwork()->getTotalNodes();
-    Utils::log("New leader elected: Node " + std::to_string(currentLeaderId));
-}
-
-void Consensus::addPendingTransaction(const Transaction& transaction) {
-    pendingTransactions.push_back(transaction);
-    Utils::log("Transaction added. Current pending size: " + std::to_string(pendingTransactions.size()));
-}
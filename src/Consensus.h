@@ -3,54 +3,115 @@
 
 #include "Message.h"
 #include "StateMachine.h"
+#include "Block.h"
+#include "WriteAheadLog.h"
+#include "VoteSet.h"
+#include "ValidatorSet.h"
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <string>
+#include <memory>
+#include <map>
+#include <array>
+#include <optional>
 
 class Node; // Forward declaration to avoid circular dependency
 class Network;
 
 enum class ConsensusStage {
-    PROPOSAL,
-    PREVOTE,
-    PRECOMMIT,
-    FINALIZED
+    PROPOSAL,  // Waiting for the round's proposal
+    PREVOTE,   // Prevoted, collecting prevotes
+    PRECOMMIT, // Precommitted, collecting precommits
+    FINALIZED  // Decided the last height, idle until there is more to agree on
 };
 
+// Tendermint consensus for one node. A height runs rounds 0, 1, ...; each round has a proposer
+// and propose/prevote/precommit steps bounded by timeouts that grow with the round. A node that
+// precommits a block locks on it and only prevotes another one after seeing a newer polka
+// (2/3+ prevotes) for it. Votes for the zero hash are nil votes. With pipelined execution the
+// decided block is stored and applied in the background while the next height is voted on.
 class Consensus {
 public:
     Consensus(Node* node, StateMachine* stateMachine);
 
-    void startConsensus();
+    void startConsensus(); // Enter the current round if there is anything to decide
     void onReceiveMessage(const Message& message);
     std::string getCurrentStageAsString() const;
     void rollbackConsensus();
-    void Consensus::addPendingTransaction(const Transaction& transaction);
+    uint64_t getHeight() const; // Height being decided
+    void reportEquivocation(int nodeId); // Ignore a validator caught signing two blocks for one slot
+    uint32_t getRound() const;
+
+    // Log proposals, own votes and decisions to walPath from now on, after replaying what an
+    // earlier run left there: a decided block is committed, an undecided round is resumed.
+    bool recover(const std::string& walPath);
 
 private:
+    // Everything seen for one round of the current height
+    struct RoundState {
+        std::shared_ptr<const Block> proposal;
+        int32_t proposalValidRound = -1;    // Round the proposer saw a polka for it, -1 for a fresh block
+        std::optional<Message> proposalMessage;
+        VoteSet prevotes;                        // First vote per validator counts, later ones are equivocation
+        VoteSet precommits;
+        BitArray senders;                        // Anyone heard from in this round, for round skipping
+        uint64_t senderPower = 0;
+        std::optional<Message> ownPrevote;       // Re-sent, never re-signed, if the round is entered again
+        std::optional<Message> ownPrecommit;
+        bool prevoteWaitArmed = false;
+        bool precommitWaitArmed = false;
+        bool polkaSeen = false;                  // Locked or updated the valid block on this round's polka
+    };
+
     Node* node;                    // Pointer to the node
     StateMachine* stateMachine;    // Pointer to the state machine
-    ConsensusStage currentStage;   // Current stage of the consensus
-    std::string proposalHash;      // Hash of the proposal
-    size_t proposalBlockIndex;     // Index of the proposal block
-    size_t currentLeaderId;        // Current leader ID
-    size_t retryCount;             // Retry count for consensus
-    size_t threshold;              // Dynamic threshold for consensus
-    std::unordered_set<size_t> prevotesReceived;
-    std::unordered_set<size_t> precommitsReceived;
+    ConsensusStage currentStage;   // Step within the current round
+    uint32_t round;
+    bool roundActive;              // False while idle between heights or after giving up
+    ValidatorSet validators;       // The network's set for the height being decided, fixed for the whole height
+    uint64_t validatorsHeight;     // Height validators was loaded for, 0 when it needs loading
+    std::vector<int> roundProposers; // Proposer of each round of this height, extended on demand
+    ValidatorSet proposerRotation;   // validators advanced to the last round in roundProposers
+    std::shared_ptr<const Block> lockedBlock; // Block we precommitted, we prevote nothing else until unlocked
+    int32_t lockedRound;
+    std::shared_ptr<const Block> validBlock;  // Latest block with a polka, re-proposed when we lead
+    int32_t validRound;
+    std::map<uint32_t, RoundState> rounds;
+    std::array<uint64_t, 3> pendingTimers; // Network timer id per step, 0 when none
+    long long heightStartMs;       // Network time round 0 was entered, for commit latency
+    long long roundStartMs;        // Network time the current round was entered
+    long long prevoteSentMs;       // When we prevoted in the current round, -1 if we have not
+    long long precommitSentMs;
     std::unordered_set<size_t> byzantineNodes;
-    std::vector<Transaction> pendingTransactions;
+    std::vector<Message> futureMessages; // Messages for heights this node has not reached yet
+    std::unique_ptr<WriteAheadLog> wal;   // Null unless recover() attached one
+    std::vector<Message> outbox;          // Own proposals and votes held back until the WAL sync covering them
+    bool walFailed;                       // A WAL sync failed; nothing is signed or sent from then on
+    std::shared_ptr<const Block> executingBlock; // Decided block handed to the executor and not waited for yet
 
-    void Consensus::waitForNewTransactions();
-    void initiateProposal();
-    void broadcastMessage(MessageType type, const std::string& content);
+    void handleMessage(const Message& message);
+    void enterRound(uint32_t newRound);
+    void propose();
     void handleProposal(const Message& message);
-    void handlePrevote(const Message& message);
-    void handlePrecommit(const Message& message);
-    void checkForTimeout();
-    void finalizeConsensus();
-    void electNewLeader();
-    bool isQuorumReached(const std::unordered_set<size_t>& votes, size_t quorumThreshold);
+    void handleVote(const Message& message);
+    bool recordVote(const Message& vote); // False for a validator's second vote in a round
+    void castVote(MessageType type, const Hash256& blockHash);
+    void evaluate(); // Apply every rule the messages received so far enable
+    void scheduleTimeout(ConsensusStage step);
+    void cancelTimeouts();
+    void handleTimeout(const Message& message);
+    void finalizeConsensus(std::shared_ptr<const Block> block, const Message& proposal);
+    void resetHeight();
+    void loadValidators(); // Copy the set for the current height and re-size any vote sets to it
+    void markSender(RoundState& state, int senderId);
+    RoundState& roundState(uint32_t forRound); // Creates the round's vote sets on first use
+    int getProposerId(uint32_t forRound);
+    void logToWal(WalEntryType type, const std::string& data);
+    void syncWal(); // Then send the outbox, or stop signing for good if the sync failed
+    void send(const Message& message);
+    const Block& getDecidedTip() const; // Last decided block, which the chain may not have yet
+    std::optional<Hash256> expectedAppHash(uint64_t height) const; // Null if this node no longer knows it
 };
 
 #endif // CONSENSUS_H
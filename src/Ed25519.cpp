@@ -0,0 +1,82 @@
+#include "Ed25519.h"
+#include <openssl/evp.h>
+#include <stdexcept>
+
+namespace {
+
+std::shared_ptr<EVP_PKEY> wrapKey(EVP_PKEY* key) {
+    if (!key) {
+        throw std::invalid_argument("Invalid Ed25519 key.");
+    }
+    return std::shared_ptr<EVP_PKEY>(key, EVP_PKEY_free);
+}
+
+std::array<uint8_t, Ed25519PublicKey::SIZE> rawPublicKey(EVP_PKEY* key) {
+    std::array<uint8_t, Ed25519PublicKey::SIZE> bytes{};
+    size_t length = bytes.size();
+    if (EVP_PKEY_get_raw_public_key(key, bytes.data(), &length) != 1 || length != bytes.size()) {
+        throw std::runtime_error("Cannot read Ed25519 public key.");
+    }
+    return bytes;
+}
+
+} // namespace
+
+Ed25519PublicKey::Ed25519PublicKey(const std::array<uint8_t, SIZE>& bytes)
+    : bytes(bytes), key(wrapKey(EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, bytes.data(), bytes.size()))) {}
+
+bool Ed25519PublicKey::verify(std::string_view message, const Ed25519Signature& signature) const {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> context(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    if (!context || EVP_DigestVerifyInit(context.get(), nullptr, nullptr, nullptr, key.get()) != 1) {
+        return false;
+    }
+    return EVP_DigestVerify(context.get(), signature.data(), signature.size(),
+                            reinterpret_cast<const unsigned char*>(message.data()), message.size()) == 1;
+}
+
+const std::array<uint8_t, Ed25519PublicKey::SIZE>& Ed25519PublicKey::getBytes() const {
+    return bytes;
+}
+
+Ed25519KeyPair::Ed25519KeyPair(std::shared_ptr<EVP_PKEY> key, const Ed25519PublicKey& publicKey)
+    : key(std::move(key)), publicKey(publicKey) {}
+
+Ed25519KeyPair Ed25519KeyPair::generate() {
+    EVP_PKEY* generated = nullptr;
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> context(EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr), EVP_PKEY_CTX_free);
+    if (!context || EVP_PKEY_keygen_init(context.get()) != 1 || EVP_PKEY_keygen(context.get(), &generated) != 1) {
+        throw std::runtime_error("Ed25519 key generation failed.");
+    }
+    std::shared_ptr<EVP_PKEY> key = wrapKey(generated);
+    return Ed25519KeyPair(key, Ed25519PublicKey(rawPublicKey(key.get())));
+}
+
+Ed25519KeyPair Ed25519KeyPair::fromSeed(const std::array<uint8_t, SEED_SIZE>& seed) {
+    std::shared_ptr<EVP_PKEY> key = wrapKey(EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, seed.data(), seed.size()));
+    return Ed25519KeyPair(key, Ed25519PublicKey(rawPublicKey(key.get())));
+}
+
+Ed25519Signature Ed25519KeyPair::sign(std::string_view message) const {
+    Ed25519Signature signature{};
+    size_t length = signature.size();
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> context(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    if (!context || EVP_DigestSignInit(context.get(), nullptr, nullptr, nullptr, key.get()) != 1 ||
+        EVP_DigestSign(context.get(), signature.data(), &length,
+                       reinterpret_cast<const unsigned char*>(message.data()), message.size()) != 1) {
+        throw std::runtime_error("Ed25519 signing failed.");
+    }
+    return signature;
+}
+
+const Ed25519PublicKey& Ed25519KeyPair::getPublicKey() const {
+    return publicKey;
+}
+
+std::array<uint8_t, Ed25519KeyPair::SEED_SIZE> Ed25519KeyPair::getSeed() const {
+    std::array<uint8_t, SEED_SIZE> seed{};
+    size_t length = seed.size();
+    if (EVP_PKEY_get_raw_private_key(key.get(), seed.data(), &length) != 1 || length != seed.size()) {
+        throw std::runtime_error("Cannot read Ed25519 private key.");
+    }
+    return seed;
+}
@@ -0,0 +1,48 @@
+#ifndef ED25519_H
+#define ED25519_H
+
+#include <array>
+#include <memory>
+#include <string_view>
+#include <cstdint>
+
+typedef struct evp_pkey_st EVP_PKEY; // From OpenSSL, kept out of this header
+
+using Ed25519Signature = std::array<uint8_t, 64>;
+
+// Ed25519 verification key. The OpenSSL key object is built once and shared by copies,
+// so verifying many messages from one validator does not re-parse the key.
+class Ed25519PublicKey {
+public:
+    static constexpr size_t SIZE = 32;
+
+    explicit Ed25519PublicKey(const std::array<uint8_t, SIZE>& bytes); // Throws std::invalid_argument
+
+    bool verify(std::string_view message, const Ed25519Signature& signature) const; // Safe to call from many threads
+    const std::array<uint8_t, SIZE>& getBytes() const;
+
+private:
+    std::array<uint8_t, SIZE> bytes;
+    std::shared_ptr<EVP_PKEY> key;
+};
+
+// Ed25519 signing key
+class Ed25519KeyPair {
+public:
+    static constexpr size_t SEED_SIZE = 32;
+
+    static Ed25519KeyPair generate();
+    static Ed25519KeyPair fromSeed(const std::array<uint8_t, SEED_SIZE>& seed); // Throws std::invalid_argument
+
+    Ed25519Signature sign(std::string_view message) const;
+    const Ed25519PublicKey& getPublicKey() const;
+    std::array<uint8_t, SEED_SIZE> getSeed() const; // The private key, for storing it
+
+private:
+    std::shared_ptr<EVP_PKEY> key;
+    Ed25519PublicKey publicKey;
+
+    Ed25519KeyPair(std::shared_ptr<EVP_PKEY> key, const Ed25519PublicKey& publicKey);
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "Hash256.h"
+#include <stdexcept>
+
+namespace {
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+}
+
+Hash256 Hash256::fromBytes(const void* data) {
+    Hash256 hash;
+    std::memcpy(hash.bytes.data(), data, SIZE);
+    return hash;
+}
+
+Hash256 Hash256::fromHex(std::string_view hex) {
+    if (hex.size() != 2 * SIZE) {
+        throw std::invalid_argument("Hash must be 64 hex digits.");
+    }
+    Hash256 hash;
+    for (size_t i = 0; i < SIZE; ++i) {
+        int high = hexValue(hex[2 * i]);
+        int low = hexValue(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            throw std::invalid_argument("Hash contains a non-hex digit.");
+        }
+        hash.bytes[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return hash;
+}
+
+std::string Hash256::toHex() const {
+    std::string hex(2 * SIZE, '0');
+    for (size_t i = 0; i < SIZE; ++i) {
+        hex[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        hex[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0F];
+    }
+    return hex;
+}
+
+std::string Hash256::toShortHex() const {
+    return toHex().substr(0, 8);
+}
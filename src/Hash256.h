@@ -0,0 +1,70 @@
+#ifndef HASH256_H
+#define HASH256_H
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+// Fixed-size SHA-256 digest. Compared and hashed as raw bytes; hex is only produced for display.
+class Hash256 {
+public:
+    static constexpr size_t SIZE = 32;
+
+    constexpr Hash256() : bytes{} {}
+    explicit constexpr Hash256(const std::array<uint8_t, SIZE>& bytes) : bytes(bytes) {}
+
+    static Hash256 fromBytes(const void* data); // Copies SIZE bytes
+    static Hash256 fromHex(std::string_view hex); // Throws std::invalid_argument unless 64 hex digits
+
+    const uint8_t* data() const { return bytes.data(); }
+    uint8_t* data() { return bytes.data(); }
+    static constexpr size_t size() { return SIZE; }
+
+    constexpr bool isZero() const {
+        for (size_t i = 0; i < SIZE; ++i) {
+            if (bytes[i] != 0) return false;
+        }
+        return true;
+    }
+
+    std::string toHex() const;
+    std::string toShortHex() const; // First 4 bytes, for logs
+
+    friend constexpr bool operator==(const Hash256& a, const Hash256& b) {
+        for (size_t i = 0; i < SIZE; ++i) {
+            if (a.bytes[i] != b.bytes[i]) return false;
+        }
+        return true;
+    }
+
+    friend constexpr bool operator!=(const Hash256& a, const Hash256& b) {
+        return !(a == b);
+    }
+
+    friend constexpr bool operator<(const Hash256& a, const Hash256& b) {
+        for (size_t i = 0; i < SIZE; ++i) {
+            if (a.bytes[i] != b.bytes[i]) return a.bytes[i] < b.bytes[i];
+        }
+        return false;
+    }
+
+private:
+    std::array<uint8_t, SIZE> bytes;
+};
+
+namespace std {
+template <>
+struct hash<Hash256> {
+    size_t operator()(const Hash256& hash) const noexcept {
+        // The digest is already uniformly distributed, so its first word is a good bucket key
+        size_t value;
+        std::memcpy(&value, hash.data(), sizeof(value));
+        return value;
+    }
+};
+}
+
+#endif
@@ -0,0 +1,280 @@
+#include "HashIndex.h"
+#include "Serialization.h"
+#include "Utils.h"
+#include "Logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int compareHash(const uint8_t* record, const Hash256& hash) {
+    return std::memcmp(record, hash.data(), Hash256::SIZE);
+}
+
+} // namespace
+
+HashIndex::HashIndex() : fsyncPolicy(FsyncPolicy::NEVER), pendingFirstHeight(0), nextHeight(0) {}
+
+HashIndex::HashIndex(const std::string& directory, const std::string& name, uint64_t blockCount, FsyncPolicy fsyncPolicy)
+    : directory(directory), name(name), fsyncPolicy(fsyncPolicy), pendingFirstHeight(0), nextHeight(0) {
+    fs::create_directories(directory);
+    load(blockCount);
+}
+
+HashIndex::~HashIndex() {
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Hash index " + name + " not written on close: " + e.what());
+    }
+}
+
+void HashIndex::load(uint64_t blockCount) {
+    struct Found {
+        uint64_t firstHeight;
+        uint64_t lastHeight;
+        fs::path path;
+    };
+    std::vector<Found> found;
+    std::string prefix = name + "-";
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+        std::string file = entry.path().filename().string();
+        if (file.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        unsigned long long first = 0;
+        unsigned long long last = 0;
+        char tail[8] = {};
+        if (std::sscanf(file.c_str() + prefix.size(), "%llu-%llu.%7s", &first, &last, tail) != 3 || std::strcmp(tail, "idx") != 0) {
+            fs::remove(entry.path()); // Left over from a write or merge that never finished
+            continue;
+        }
+        found.push_back({first, last, entry.path()});
+    }
+
+    // A merge that stopped before deleting its inputs leaves runs covered by the merged one
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+        return a.firstHeight != b.firstHeight ? a.firstHeight < b.firstHeight : a.lastHeight > b.lastHeight;
+    });
+    for (const Found& candidate : found) {
+        if (candidate.firstHeight == nextHeight && candidate.lastHeight >= candidate.firstHeight && candidate.lastHeight < blockCount) {
+            try {
+                runs.push_back(openRun(candidate.firstHeight, candidate.lastHeight));
+                nextHeight = candidate.lastHeight + 1;
+                continue;
+            } catch (const std::exception& e) {
+                LOG_WARN("Dropping hash index run " + candidate.path.string() + ": " + e.what());
+            }
+        }
+        // Covered, unreadable, or past a gap or the store's last block: rebuilt from the blocks instead
+        fs::remove(candidate.path);
+    }
+    pendingFirstHeight = nextHeight;
+}
+
+void HashIndex::add(const Hash256& hash, int height, uint32_t position) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if (height < 0 || static_cast<uint64_t>(height) < nextHeight) {
+        return;
+    }
+    pending.emplace(hash, Location{height, position}); // A resubmitted duplicate keeps its first inclusion
+}
+
+void HashIndex::endHeight(int height) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if (height < 0 || static_cast<uint64_t>(height) < nextHeight) {
+        return;
+    }
+    nextHeight = static_cast<uint64_t>(height) + 1;
+    if (!directory.empty() && nextHeight - pendingFirstHeight >= Config::getIndexFlushInterval()) {
+        flushLocked();
+    }
+}
+
+std::optional<HashIndex::Location> HashIndex::find(const Hash256& hash) const {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    // Older runs first, so a duplicate resolves to its first inclusion
+    for (const auto& run : runs) {
+        if (std::optional<Location> location = search(*run, hash)) {
+            return location;
+        }
+    }
+    auto it = pending.find(hash);
+    if (it == pending.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+uint64_t HashIndex::getIndexedHeights() const {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return nextHeight;
+}
+
+size_t HashIndex::getRunCount() const {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return runs.size();
+}
+
+void HashIndex::flush() {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    flushLocked();
+}
+
+void HashIndex::flushLocked() {
+    if (directory.empty() || nextHeight == pendingFirstHeight) {
+        return;
+    }
+
+    std::string records;
+    records.reserve(pending.size() * RECORD_SIZE);
+    ByteWriter writer(records);
+    std::vector<std::pair<Hash256, Location>> sorted(pending.begin(), pending.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& entry : sorted) {
+        writer.writeBytes(entry.first.data(), Hash256::SIZE);
+        writer.writeU64(static_cast<uint64_t>(entry.second.height));
+        writer.writeU32(entry.second.position);
+    }
+    std::vector<const uint8_t*> pointers(sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        pointers[i] = reinterpret_cast<const uint8_t*>(records.data()) + i * RECORD_SIZE;
+    }
+
+    uint64_t lastHeight = nextHeight - 1;
+    writeRun(runPath(pendingFirstHeight, lastHeight), pointers);
+    runs.push_back(openRun(pendingFirstHeight, lastHeight));
+    pending.clear();
+    pendingFirstHeight = nextHeight;
+    mergeRuns();
+}
+
+void HashIndex::mergeRuns() {
+    while (runs.size() >= 2) {
+        const Run& older = *runs[runs.size() - 2];
+        const Run& newer = *runs.back();
+        if (newer.lastHeight - newer.firstHeight < older.lastHeight - older.firstHeight) {
+            return;
+        }
+
+        // Both inputs are sorted; on equal hashes the older location wins
+        std::vector<const uint8_t*> merged;
+        merged.reserve(older.count + newer.count);
+        size_t i = 0;
+        size_t j = 0;
+        while (i < older.count || j < newer.count) {
+            if (j == newer.count) {
+                merged.push_back(older.record(i++));
+            } else if (i == older.count) {
+                merged.push_back(newer.record(j++));
+            } else {
+                int order = std::memcmp(older.record(i), newer.record(j), Hash256::SIZE);
+                if (order <= 0) {
+                    merged.push_back(older.record(i++));
+                    j += order == 0 ? 1 : 0;
+                } else {
+                    merged.push_back(newer.record(j++));
+                }
+            }
+        }
+
+        uint64_t firstHeight = older.firstHeight;
+        uint64_t lastHeight = newer.lastHeight;
+        writeRun(runPath(firstHeight, lastHeight), merged);
+        std::string olderPath = older.path;
+        std::string newerPath = newer.path;
+        runs.pop_back();
+        runs.pop_back(); // Unmaps the inputs before they are deleted
+        fs::remove(olderPath);
+        fs::remove(newerPath);
+        syncDirectory();
+        runs.push_back(openRun(firstHeight, lastHeight));
+    }
+}
+
+std::unique_ptr<HashIndex::Run> HashIndex::openRun(uint64_t firstHeight, uint64_t lastHeight) const {
+    auto run = std::make_unique<Run>();
+    run->firstHeight = firstHeight;
+    run->lastHeight = lastHeight;
+    run->path = runPath(firstHeight, lastHeight);
+    run->file.open(run->path);
+    if (run->file.size() < RUN_HEADER_SIZE) {
+        throw std::runtime_error("Hash index run is too short.");
+    }
+    ByteReader reader(run->file.view(0, RUN_HEADER_SIZE));
+    if (reader.readU32() != RUN_MAGIC) {
+        throw std::runtime_error("Not a hash index run.");
+    }
+    run->count = static_cast<size_t>(reader.readU64());
+    if (run->file.size() != RUN_HEADER_SIZE + run->count * RECORD_SIZE) {
+        throw std::runtime_error("Hash index run has the wrong size.");
+    }
+    return run;
+}
+
+void HashIndex::writeRun(const std::string& path, const std::vector<const uint8_t*>& records) const {
+    std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot create " + temporary);
+    }
+    std::string header;
+    ByteWriter writer(header);
+    writer.writeU32(RUN_MAGIC);
+    writer.writeU64(records.size());
+    bool written = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+    for (size_t i = 0; written && i < records.size(); ++i) {
+        written = std::fwrite(records[i], 1, RECORD_SIZE, file) == RECORD_SIZE;
+    }
+    written = std::fflush(file) == 0 && written;
+    if (written && fsyncPolicy != FsyncPolicy::NEVER) {
+        written = Utils::syncFile(file); // The rename must not become durable before the contents
+    }
+    std::fclose(file);
+    if (!written) {
+        fs::remove(temporary);
+        throw std::runtime_error("Cannot write to " + temporary);
+    }
+    fs::rename(temporary, path);
+    syncDirectory(); // A merge deletes its inputs only once the merged run is sure to be found
+}
+
+void HashIndex::syncDirectory() const {
+    if (fsyncPolicy != FsyncPolicy::NEVER && !Utils::syncDirectory(directory)) {
+        throw std::runtime_error("Cannot sync " + directory);
+    }
+}
+
+std::string HashIndex::runPath(uint64_t firstHeight, uint64_t lastHeight) const {
+    char file[96];
+    std::snprintf(file, sizeof(file), "-%010llu-%010llu.idx", static_cast<unsigned long long>(firstHeight),
+                  static_cast<unsigned long long>(lastHeight));
+    return (fs::path(directory) / (name + file)).string();
+}
+
+std::optional<HashIndex::Location> HashIndex::search(const Run& run, const Hash256& hash) {
+    size_t low = 0;
+    size_t high = run.count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order = compareHash(run.record(middle), hash);
+        if (order == 0) {
+            ByteReader reader(std::string_view(reinterpret_cast<const char*>(run.record(middle)) + Hash256::SIZE, 12));
+            Location location;
+            location.height = static_cast<int>(reader.readU64());
+            location.position = reader.readU32();
+            return location;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return std::nullopt;
+}
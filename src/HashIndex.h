@@ -0,0 +1,82 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include "Hash256.h"
+#include "Config.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+
+// Maps hashes to where they sit in the chain without holding the whole chain's worth in memory.
+// Entries for the latest heights collect in memory and are written every few blocks as a run: a
+// file of records sorted by hash, named after the heights it covers and binary-searched through a
+// memory map. A run is merged into the one before it once it covers as many heights, so a chain
+// of n blocks keeps O(log n) runs. Every entry can be derived again from the blocks, so on open
+// runs that do not line up with the block store are deleted, and the caller adds the heights from
+// getIndexedHeights() on again.
+class HashIndex {
+public:
+    struct Location {
+        int height;
+        uint32_t position; // Meaning is up to the caller, e.g. a transaction's place in its block
+    };
+
+    HashIndex(); // Memory only, for chains that are not persisted
+    // Throws std::runtime_error
+    HashIndex(const std::string& directory, const std::string& name, uint64_t blockCount,
+              FsyncPolicy fsyncPolicy = Config::getFsyncPolicy());
+    ~HashIndex(); // Writes out the entries still in memory
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    // Heights must be added in order. Heights already indexed are ignored, and a hash that is
+    // already present keeps its first location.
+    void add(const Hash256& hash, int height, uint32_t position = 0);
+    void endHeight(int height); // Every entry of height has been added
+    std::optional<Location> find(const Hash256& hash) const;
+    uint64_t getIndexedHeights() const; // Heights [0, n) are fully indexed
+    size_t getRunCount() const;
+    void flush(); // Write the entries in memory as a run
+
+    static const uint32_t RUN_MAGIC = 0x4E52484D; // "MHRN"
+    static const size_t RUN_HEADER_SIZE = 4 + 8; // magic, record count
+    static const size_t RECORD_SIZE = Hash256::SIZE + 8 + 4; // hash, height, position
+
+private:
+    struct Run {
+        uint64_t firstHeight;
+        uint64_t lastHeight;
+        std::string path;
+        MappedFile file;
+        size_t count;
+
+        const uint8_t* record(size_t i) const { return file.data() + RUN_HEADER_SIZE + i * RECORD_SIZE; }
+    };
+
+    std::string directory; // Empty for a memory-only index
+    std::string name;
+    FsyncPolicy fsyncPolicy;
+
+    std::vector<std::unique_ptr<Run>> runs; // Oldest heights first, contiguous from height 0
+    std::unordered_map<Hash256, Location> pending;
+    uint64_t pendingFirstHeight; // First height not yet in a run
+    uint64_t nextHeight;         // First height not yet ended
+    mutable std::mutex indexMutex;
+
+    void load(uint64_t blockCount);
+    void flushLocked();
+    void mergeRuns();
+    std::unique_ptr<Run> openRun(uint64_t firstHeight, uint64_t lastHeight) const; // Throws std::runtime_error
+    void writeRun(const std::string& path, const std::vector<const uint8_t*>& records) const;
+    void syncDirectory() const; // Throws std::runtime_error
+    std::string runPath(uint64_t firstHeight, uint64_t lastHeight) const;
+    static std::optional<Location> search(const Run& run, const Hash256& hash);
+};
+
+#endif
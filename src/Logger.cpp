@@ -0,0 +1,251 @@
+#include "Logger.h"
+#include "Config.h"
+#include "Serialization.h"
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <cctype>
+
+std::atomic<uint8_t> Logger::runtimeLevel(static_cast<uint8_t>(LogLevel::INFO));
+
+namespace {
+
+const size_t DRAIN_BATCH = 1024; // Records written between sink flushes
+const std::chrono::milliseconds WRITER_IDLE_WAIT(10);
+
+std::FILE* openLogFile(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        throw std::runtime_error("Cannot open log file " + path + ".");
+    }
+    return file;
+}
+
+void appendJsonString(std::string& out, std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    out.push_back('"');
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out.push_back(HEX[(c >> 4) & 0xF]);
+                    out.push_back(HEX[c & 0xF]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+} // namespace
+
+TextLogSink::TextLogSink(std::FILE* file) : file(file) {}
+
+void TextLogSink::write(const LogRecord& record) {
+    std::fprintf(file, "[%s] %s\n", Logger::levelName(record.level), record.message.c_str());
+}
+
+void TextLogSink::flush() {
+    std::fflush(file);
+}
+
+JsonLogSink::JsonLogSink(const std::string& path) : file(openLogFile(path)) {}
+
+JsonLogSink::~JsonLogSink() {
+    std::fclose(file);
+}
+
+void JsonLogSink::write(const LogRecord& record) {
+    std::string line = "{\"ts\":" + std::to_string(record.timestampUs) + ",\"level\":\"" + Logger::levelName(record.level) +
+                       "\",\"thread\":" + std::to_string(record.threadId) + ",\"msg\":";
+    appendJsonString(line, record.message);
+    line += "}\n";
+    std::fwrite(line.data(), 1, line.size(), file);
+}
+
+void JsonLogSink::flush() {
+    std::fflush(file);
+}
+
+BinaryLogSink::BinaryLogSink(const std::string& path) : file(openLogFile(path)) {}
+
+BinaryLogSink::~BinaryLogSink() {
+    flush();
+    std::fclose(file);
+}
+
+void BinaryLogSink::write(const LogRecord& record) {
+    ByteWriter writer(buffer);
+    writer.writeU64(record.timestampUs);
+    writer.writeU8(static_cast<uint8_t>(record.level));
+    writer.writeU64(record.threadId);
+    writer.writeU32(static_cast<uint32_t>(record.message.size()));
+    writer.writeBytes(record.message.data(), record.message.size());
+}
+
+void BinaryLogSink::flush() {
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    std::fflush(file);
+    buffer.clear();
+}
+
+Logger::Logger() : ring(Config::getLogBufferSize()), written(0), drained(0), dropped(0), stopping(false) {
+    sinks.push_back(std::make_unique<TextLogSink>());
+    writer = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+    stopping = true;
+    wakeCondition.notify_one();
+    writer.join();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+void Logger::setLevel(LogLevel level) {
+    runtimeLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() {
+    return static_cast<LogLevel>(runtimeLevel.load(std::memory_order_relaxed));
+}
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE:
+            return "TRACE";
+        case LogLevel::DEBUG:
+            return "DEBUG";
+        case LogLevel::INFO:
+            return "INFO";
+        case LogLevel::WARN:
+            return "WARN";
+        case LogLevel::ERROR:
+            return "ERROR";
+        default:
+            return "OFF";
+    }
+}
+
+bool Logger::parseLevel(std::string_view name, LogLevel& level) {
+    for (LogLevel candidate : {LogLevel::TRACE, LogLevel::DEBUG, LogLevel::INFO, LogLevel::WARN, LogLevel::ERROR, LogLevel::OFF}) {
+        std::string_view candidateName = levelName(candidate);
+        bool equal = candidateName.size() == name.size();
+        for (size_t i = 0; equal && i < name.size(); ++i) {
+            equal = std::toupper(static_cast<unsigned char>(name[i])) == candidateName[i];
+        }
+        if (equal) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Logger::write(LogLevel level, std::string message) {
+    LogRecord record;
+    record.timestampUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    record.level = level;
+    record.threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+    record.message = std::move(message);
+    if (ring.push(std::move(record))) {
+        written.fetch_add(1, std::memory_order_release);
+    } else {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::addSink(std::unique_ptr<LogSink> sink) {
+    std::lock_guard<std::mutex> lock(sinksMutex);
+    sinks.push_back(std::move(sink));
+}
+
+void Logger::clearSinks() {
+    std::lock_guard<std::mutex> lock(sinksMutex);
+    for (auto& sink : sinks) {
+        sink->flush();
+    }
+    sinks.clear();
+}
+
+void Logger::flush() {
+    uint64_t target = written.load(std::memory_order_acquire);
+    wakeCondition.notify_one();
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    drainedCondition.wait(lock, [this, target] { return drained.load() >= target; });
+}
+
+uint64_t Logger::getDroppedCount() const {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+void Logger::writerLoop() {
+    uint64_t reportedDrops = 0;
+    while (true) {
+        bool any = drain();
+        uint64_t drops = dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            // Goes through the ring like any record; if that is still full, the next pass reports it
+            write(LogLevel::WARN, std::to_string(drops - reportedDrops) + " log records dropped, the ring was full.");
+            reportedDrops = drops;
+            continue;
+        }
+        if (any) {
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait_for(lock, WRITER_IDLE_WAIT);
+    }
+}
+
+bool Logger::drain() {
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(sinksMutex);
+        while (count < DRAIN_BATCH) {
+            std::optional<LogRecord> record = ring.pop();
+            if (!record) {
+                break;
+            }
+            for (auto& sink : sinks) {
+                sink->write(*record);
+            }
+            ++count;
+        }
+        if (count != 0) {
+            for (auto& sink : sinks) {
+                sink->flush();
+            }
+        }
+    }
+    if (count == 0) {
+        return false;
+    }
+    drained.fetch_add(count);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex); // Orders the update before a flusher's check
+    }
+    drainedCondition.notify_all();
+    return true;
+}
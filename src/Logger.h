@@ -0,0 +1,152 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "RingBuffer.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+
+enum class LogLevel : uint8_t {
+    TRACE,
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    OFF
+};
+
+// Levels below this are compiled out entirely: build with -DLOG_COMPILE_LEVEL=2 to drop TRACE and DEBUG
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+constexpr bool isLogLevelCompiled(LogLevel level) {
+#if LOG_COMPILE_LEVEL > 0
+    return static_cast<int>(level) >= LOG_COMPILE_LEVEL;
+#else
+    (void)level; // Every level is compiled in; comparing against 0 would always be true
+    return true;
+#endif
+}
+
+// The message expression is only evaluated when the level is enabled, so disabled calls cost a compare
+#define LOG_AT(level, message)                                                                  \
+    do {                                                                                        \
+        if constexpr (isLogLevelCompiled(level)) {                                              \
+            if (Logger::isEnabled(level)) {                                                     \
+                Logger::instance().write(level, message);                                       \
+            }                                                                                   \
+        }                                                                                       \
+    } while (0)
+
+#define LOG_TRACE(message) LOG_AT(LogLevel::TRACE, message)
+#define LOG_DEBUG(message) LOG_AT(LogLevel::DEBUG, message)
+#define LOG_INFO(message) LOG_AT(LogLevel::INFO, message)
+#define LOG_WARN(message) LOG_AT(LogLevel::WARN, message)
+#define LOG_ERROR(message) LOG_AT(LogLevel::ERROR, message)
+
+struct LogRecord {
+    uint64_t timestampUs = 0; // Since the Unix epoch
+    LogLevel level = LogLevel::INFO;
+    uint64_t threadId = 0;
+    std::string message;
+};
+
+// Where the writer thread puts records. Only the writer thread calls these.
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void write(const LogRecord& record) = 0;
+    virtual void flush() {}
+};
+
+// "[LEVEL] message" lines, on stdout unless given a file
+class TextLogSink : public LogSink {
+public:
+    explicit TextLogSink(std::FILE* file = stdout);
+    void write(const LogRecord& record) override;
+    void flush() override;
+
+private:
+    std::FILE* file;
+};
+
+// One JSON object per line: {"ts":..,"level":"..","thread":..,"msg":".."}
+class JsonLogSink : public LogSink {
+public:
+    explicit JsonLogSink(const std::string& path); // Throws std::runtime_error
+    ~JsonLogSink() override;
+    void write(const LogRecord& record) override;
+    void flush() override;
+
+private:
+    std::FILE* file;
+};
+
+// Per record: timestamp u64 | level u8 | thread u64 | size u32 | message bytes, little-endian
+class BinaryLogSink : public LogSink {
+public:
+    explicit BinaryLogSink(const std::string& path); // Throws std::runtime_error
+    ~BinaryLogSink() override;
+    void write(const LogRecord& record) override;
+    void flush() override;
+
+    static const size_t RECORD_HEADER_SIZE = 8 + 1 + 8 + 4;
+
+private:
+    std::FILE* file;
+    std::string buffer;
+};
+
+// Process-wide asynchronous logger. Callers format a record and push it into a lock-free ring;
+// a background thread drains the ring into the sinks, so no caller waits on I/O. When the ring is
+// full the record is dropped and counted rather than blocking consensus.
+class Logger {
+public:
+    static Logger& instance();
+    ~Logger(); // Drains what is queued
+
+    static bool isEnabled(LogLevel level) {
+        return static_cast<uint8_t>(level) >= runtimeLevel.load(std::memory_order_relaxed);
+    }
+    static void setLevel(LogLevel level);
+    static LogLevel getLevel();
+    static const char* levelName(LogLevel level);
+    static bool parseLevel(std::string_view name, LogLevel& level); // False for an unknown name
+
+    void write(LogLevel level, std::string message);
+    void addSink(std::unique_ptr<LogSink> sink);
+    void clearSinks(); // Records are dropped until a sink is added
+    void flush();      // Returns once everything logged so far is in the sinks
+
+    uint64_t getDroppedCount() const;
+
+private:
+    Logger();
+
+    RingBuffer<LogRecord> ring;
+    std::vector<std::unique_ptr<LogSink>> sinks;
+    std::mutex sinksMutex; // Held by the writer while it drains; addSink and flush wait for it
+    std::atomic<uint64_t> written;   // Records pushed into the ring
+    std::atomic<uint64_t> drained;   // Records taken out by the writer
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> stopping;
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable drainedCondition;
+
+    static std::atomic<uint8_t> runtimeLevel;
+
+    void writerLoop();
+    bool drain(); // False if the ring was empty
+};
+
+#endif
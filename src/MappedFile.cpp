@@ -0,0 +1,107 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : mapping(nullptr), mappedSize(0), fileHandle(nullptr), mappingHandle(nullptr) {}
+#else
+MappedFile::MappedFile() : mapping(nullptr), mappedSize(0) {}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+void MappedFile::open(const std::string& path) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open " + path + " for mapping.");
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot stat " + path + ".");
+    }
+    fileHandle = file;
+    if (fileSize.QuadPart == 0) {
+        return;
+    }
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        throw std::runtime_error("Cannot map " + path + ".");
+    }
+    mapping = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!mapping) {
+        close();
+        throw std::runtime_error("Cannot map " + path + ".");
+    }
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+}
+
+void MappedFile::close() {
+    if (mapping) {
+        UnmapViewOfFile(mapping);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+    mapping = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    mappedSize = 0;
+}
+#else
+void MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + " for mapping.");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path + ".");
+    }
+    if (info.st_size > 0) {
+        void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path + ".");
+        }
+        mapping = static_cast<const uint8_t*>(address);
+        mappedSize = static_cast<size_t>(info.st_size);
+    }
+    ::close(fd); // The mapping keeps the file referenced
+}
+
+void MappedFile::close() {
+    if (mapping) {
+        munmap(const_cast<uint8_t*>(mapping), mappedSize);
+    }
+    mapping = nullptr;
+    mappedSize = 0;
+}
+#endif
+
+std::string_view MappedFile::view(size_t offset, size_t length) const {
+    if (offset > mappedSize || mappedSize - offset < length) {
+        throw std::out_of_range("Read past the end of a mapped file.");
+    }
+    return std::string_view(reinterpret_cast<const char*>(mapping) + offset, length);
+}
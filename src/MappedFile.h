@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only memory map of a whole file. Maps nothing for an empty file.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    void open(const std::string& path); // Throws std::runtime_error; remaps if already open
+    void close();
+
+    const uint8_t* data() const { return mapping; }
+    size_t size() const { return mappedSize; }
+    std::string_view view(size_t offset, size_t length) const; // Throws std::out_of_range past the mapped end
+
+private:
+    const uint8_t* mapping;
+    size_t mappedSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
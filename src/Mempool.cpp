@@ -0,0 +1,130 @@
+#include "Mempool.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <algorithm>
+
+Mempool::Mempool(size_t capacity, MempoolOrdering ordering)
+    : capacity(capacity), ordering(ordering), nextArrival(0), totalBytes(0) {}
+
+void Mempool::publishSize() const {
+    static Gauge& transactions = Metrics::gauge("mempool_transactions", "Transactions waiting in the mempool");
+    static Gauge& bytes = Metrics::gauge("mempool_bytes", "Encoded size of the transactions waiting in the mempool");
+    transactions.set(static_cast<int64_t>(byHash.size()));
+    bytes.set(static_cast<int64_t>(totalBytes));
+}
+
+Mempool::PriorityKey Mempool::makeKey(const Transaction& transaction, uint64_t arrival) const {
+    // Under FIFO every fee compares equal, so arrival decides
+    return {ordering == MempoolOrdering::FEE ? transaction.getFee() : 0.0, arrival};
+}
+
+bool Mempool::addTransaction(const Transaction& transaction) {
+    Hash256 hash = transaction.getHash();
+
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    if (byHash.count(hash)) {
+        LOG_DEBUG("Duplicate transaction ignored by mempool.");
+        return false;
+    }
+    if (byHash.size() >= capacity) {
+        LOG_WARN("Mempool full, transaction rejected.");
+        return false;
+    }
+
+    PriorityKey key = makeKey(transaction, nextArrival++);
+    byPriority.emplace(key, transaction);
+    byHash.emplace(hash, key);
+    totalBytes += transaction.getSize();
+    publishSize();
+    return true;
+}
+
+std::vector<Transaction> Mempool::reapBatch(size_t maxTransactions, size_t maxBytes) const {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    std::vector<Transaction> batch;
+    batch.reserve(std::min(maxTransactions, byPriority.size()));
+
+    size_t batchBytes = 0;
+    for (const auto& [key, transaction] : byPriority) {
+        if (batch.size() >= maxTransactions || batchBytes + transaction.getSize() > maxBytes) {
+            break;
+        }
+        batchBytes += transaction.getSize();
+        batch.push_back(transaction);
+    }
+    return batch;
+}
+
+void Mempool::removeCommitted(const std::vector<Transaction>& committed) {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    for (const auto& transaction : committed) {
+        auto it = byHash.find(transaction.getHash());
+        if (it == byHash.end()) {
+            continue; // Already evicted by another node committing the same block
+        }
+        totalBytes -= transaction.getSize();
+        byPriority.erase(it->second);
+        byHash.erase(it);
+    }
+    publishSize();
+}
+
+bool Mempool::contains(const Transaction& transaction) const {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    return byHash.count(transaction.getHash()) > 0;
+}
+
+size_t Mempool::size() const {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    return byHash.size();
+}
+
+size_t Mempool::sizeBytes() const {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    return totalBytes;
+}
+
+bool Mempool::empty() const {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    return byHash.empty();
+}
+
+std::vector<Transaction> Mempool::getTransactions() const {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    std::vector<Transaction> transactions;
+    transactions.reserve(byPriority.size());
+    for (const auto& [key, transaction] : byPriority) {
+        transactions.push_back(transaction);
+    }
+    return transactions;
+}
+
+void Mempool::clear() {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    byPriority.clear();
+    byHash.clear();
+    totalBytes = 0;
+    publishSize();
+}
+
+void Mempool::setOrdering(MempoolOrdering newOrdering) {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    if (newOrdering == ordering) {
+        return;
+    }
+    ordering = newOrdering;
+
+    // Re-key every entry under the new ordering, keeping arrival numbers
+    std::map<PriorityKey, Transaction> reordered;
+    for (auto& [key, transaction] : byPriority) {
+        PriorityKey newKey = makeKey(transaction, key.arrival);
+        byHash[transaction.getHash()] = newKey;
+        reordered.emplace(newKey, transaction);
+    }
+    byPriority.swap(reordered);
+}
+
+MempoolOrdering Mempool::getOrdering() const {
+    std::lock_guard<std::mutex> lock(mempoolMutex);
+    return ordering;
+}
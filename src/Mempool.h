@@ -0,0 +1,64 @@
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include "Transaction.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <cstdint>
+
+// Order in which proposers take transactions out of the pool
+enum class MempoolOrdering {
+    FIFO, // Arrival order
+    FEE   // Highest fee first, arrival order between equal fees
+};
+
+// Transactions waiting to be included in a block. Entries stay in the pool
+// while a proposal is in flight and are only evicted once committed.
+class Mempool {
+public:
+    Mempool(size_t capacity = 100000, MempoolOrdering ordering = MempoolOrdering::FIFO);
+
+    bool addTransaction(const Transaction& transaction); // False for duplicates or when the pool is full
+    std::vector<Transaction> reapBatch(size_t maxTransactions, size_t maxBytes) const; // Next block's worth, in priority order
+    void removeCommitted(const std::vector<Transaction>& committed); // Evict transactions that made it into a block
+
+    bool contains(const Transaction& transaction) const;
+    size_t size() const;
+    size_t sizeBytes() const;
+    bool empty() const;
+    std::vector<Transaction> getTransactions() const;
+    void clear();
+
+    void setOrdering(MempoolOrdering ordering);
+    MempoolOrdering getOrdering() const;
+
+private:
+    // Smaller keys are reaped first
+    struct PriorityKey {
+        double fee;
+        uint64_t arrival;
+
+        bool operator<(const PriorityKey& other) const {
+            if (fee != other.fee) {
+                return fee > other.fee;
+            }
+            return arrival < other.arrival;
+        }
+    };
+
+    mutable std::mutex mempoolMutex;
+    size_t capacity;
+    MempoolOrdering ordering;
+    uint64_t nextArrival;
+    size_t totalBytes;
+    std::map<PriorityKey, Transaction> byPriority;         // Reap order
+    std::unordered_map<Hash256, PriorityKey> byHash;       // Deduplication and eviction
+
+    PriorityKey makeKey(const Transaction& transaction, uint64_t arrival) const;
+    void publishSize() const; // Update the size gauges; caller holds mempoolMutex
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "MerkleTree.h"
+#include "Sha256.h"
+#include "ThreadPool.h"
+#include <cstring>
+#include <stdexcept>
+
+MerkleTree::MerkleTree() {}
+
+MerkleTree::MerkleTree(const std::vector<Transaction>& transactions) {
+    if (transactions.empty()) {
+        return;
+    }
+
+    std::vector<Hash256> leaves(transactions.size());
+    auto hashLeaves = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            leaves[i] = hashLeaf(transactions[i]);
+        }
+    };
+    if (transactions.size() >= PARALLEL_LEAF_THRESHOLD) {
+        ThreadPool::shared().parallelFor(transactions.size(), PARALLEL_LEAF_THRESHOLD / 4, hashLeaves);
+    } else {
+        hashLeaves(0, transactions.size());
+    }
+    levels.push_back(std::move(leaves));
+
+    while (levels.back().size() > 1) {
+        const std::vector<Hash256>& below = levels.back();
+        std::vector<Hash256> above;
+        above.reserve((below.size() + 1) / 2);
+        for (size_t i = 0; i + 1 < below.size(); i += 2) {
+            above.push_back(hashInner(below[i], below[i + 1]));
+        }
+        if (below.size() % 2 == 1) {
+            above.push_back(below.back());
+        }
+        levels.push_back(std::move(above));
+    }
+    root = levels.back().front();
+}
+
+const Hash256& MerkleTree::getRoot() const {
+    return root;
+}
+
+size_t MerkleTree::getLeafCount() const {
+    return levels.empty() ? 0 : levels.front().size();
+}
+
+MerkleProof MerkleTree::getProof(size_t index) const {
+    if (index >= getLeafCount()) {
+        throw std::out_of_range("Transaction index outside the block.");
+    }
+
+    MerkleProof proof{index, getLeafCount(), {}};
+    size_t position = index;
+    for (size_t level = 0; level + 1 < levels.size(); ++level) {
+        const std::vector<Hash256>& nodes = levels[level];
+        if (position % 2 == 1) {
+            proof.siblings.push_back(nodes[position - 1]);
+        } else if (position + 1 < nodes.size()) {
+            proof.siblings.push_back(nodes[position + 1]);
+        }
+        position /= 2;
+    }
+    return proof;
+}
+
+bool MerkleTree::verifyProof(const Transaction& transaction, const MerkleProof& proof, const Hash256& root) {
+    if (proof.index >= proof.leafCount) {
+        return false;
+    }
+
+    Hash256 hash = hashLeaf(transaction);
+    size_t position = proof.index;
+    size_t width = proof.leafCount;
+    size_t used = 0;
+    while (width > 1) {
+        if (position % 2 == 1) {
+            if (used == proof.siblings.size()) return false;
+            hash = hashInner(proof.siblings[used++], hash);
+        } else if (position + 1 < width) {
+            if (used == proof.siblings.size()) return false;
+            hash = hashInner(hash, proof.siblings[used++]);
+        }
+        position /= 2;
+        width = (width + 1) / 2;
+    }
+    return used == proof.siblings.size() && hash == root;
+}
+
+Hash256 MerkleTree::hashLeaf(const Transaction& transaction) {
+    uint8_t leaf[1 + Transaction::ENCODED_SIZE];
+    leaf[0] = 0x00;
+    transaction.encode(leaf + 1);
+    return Sha256::digest(leaf, sizeof(leaf));
+}
+
+Hash256 MerkleTree::hashInner(const Hash256& left, const Hash256& right) {
+    uint8_t inner[1 + 2 * Hash256::SIZE];
+    inner[0] = 0x01;
+    std::memcpy(inner + 1, left.data(), Hash256::SIZE);
+    std::memcpy(inner + 1 + Hash256::SIZE, right.data(), Hash256::SIZE);
+    return Sha256::digest(inner, sizeof(inner));
+}
@@ -0,0 +1,39 @@
+#ifndef MERKLE_TREE_H
+#define MERKLE_TREE_H
+
+#include "Hash256.h"
+#include "Transaction.h"
+#include <vector>
+#include <cstddef>
+
+// Sibling hashes from a leaf up to the root. Levels where the node was the odd one
+// out carry it up unchanged and contribute no sibling.
+struct MerkleProof {
+    size_t index;      // Position of the transaction in the block
+    size_t leafCount;  // Number of transactions in the block, fixes the tree shape
+    std::vector<Hash256> siblings;
+};
+
+// Binary hash tree over a block's transactions. Leaves are H(0x00 || tx), inner
+// nodes H(0x01 || left || right), and an odd node at the end of a level moves up as is.
+class MerkleTree {
+public:
+    MerkleTree();
+    explicit MerkleTree(const std::vector<Transaction>& transactions);
+
+    const Hash256& getRoot() const; // All-zero for an empty tree
+    size_t getLeafCount() const;
+    MerkleProof getProof(size_t index) const; // Throws std::out_of_range
+
+    static bool verifyProof(const Transaction& transaction, const MerkleProof& proof, const Hash256& root);
+    static Hash256 hashLeaf(const Transaction& transaction);
+    static Hash256 hashInner(const Hash256& left, const Hash256& right);
+
+    static const size_t PARALLEL_LEAF_THRESHOLD = 4096; // Below this, spreading leaves over threads costs more than it saves
+
+private:
+    std::vector<std::vector<Hash256>> levels; // levels[0] are the leaves, levels.back() holds the root
+    Hash256 root;
+};
+
+#endif
@@ -1,7 +1,17 @@
 #include "Message.h"
+#include "Serialization.h"
+#include "Utils.h"
+#include <stdexcept>
+#include <algorithm>
 
 Message::Message(MessageType type, int senderId, const std::string& content)
-    : type(type), senderId(senderId), content(content) {}
+    : type(type), senderId(senderId), height(0), round(0), blockHash(), signature{},
+      payloadBuffer(std::make_shared<const std::string>(content)), payloadOffset(0), payloadSize(content.size()) {}
+
+Message::Message(MessageType type, int senderId, uint64_t height, uint32_t round, const Hash256& blockHash,
+                 std::shared_ptr<const std::string> payload)
+    : type(type), senderId(senderId), height(height), round(round), blockHash(blockHash), signature{},
+      payloadBuffer(std::move(payload)), payloadOffset(0), payloadSize(payloadBuffer ? payloadBuffer->size() : 0) {}
 
 MessageType Message::getType() const {
     return type;
@@ -11,6 +21,115 @@ int Message::getSenderId() const {
     return senderId;
 }
 
-std::string Message::getContent() const {
-    return content;
+uint64_t Message::getHeight() const {
+    return height;
+}
+
+uint32_t Message::getRound() const {
+    return round;
+}
+
+const Hash256& Message::getBlockHash() const {
+    return blockHash;
+}
+
+std::string_view Message::getPayload() const {
+    if (!payloadBuffer) {
+        return {};
+    }
+    return std::string_view(*payloadBuffer).substr(payloadOffset, payloadSize);
+}
+
+const char* Message::getTypeName(MessageType type) {
+    static const char* typeNames[] = {"PROPOSAL", "PREVOTE", "PRECOMMIT", "ROLLBACK", "TIMEOUT"};
+    return static_cast<size_t>(type) < sizeof(typeNames) / sizeof(typeNames[0]) ? typeNames[type] : "UNKNOWN";
+}
+
+std::string Message::toString() const {
+    return std::string(getTypeName(type)) + " from Node " + std::to_string(senderId) + " at height " +
+           std::to_string(height) + " round " + std::to_string(round) + " for block " +
+           blockHash.toShortHex();
+}
+
+std::string Message::getSignBytes() const {
+    std::string out;
+    out.reserve(1 + 8 + 4 + 4 + 2 * Hash256::SIZE);
+    ByteWriter writer(out);
+    writer.writeU8(static_cast<uint8_t>(type));
+    writer.writeU64(height);
+    writer.writeU32(round);
+    writer.writeI32(senderId);
+    writer.writeBytes(blockHash.data(), Hash256::SIZE);
+    Hash256 payloadHash = payloadSize == 0 ? Hash256() : Utils::calculateHash(getPayload());
+    writer.writeBytes(payloadHash.data(), Hash256::SIZE);
+    return out;
+}
+
+void Message::setSignature(const Ed25519Signature& newSignature) {
+    signature = newSignature;
+}
+
+const Ed25519Signature& Message::getSignature() const {
+    return signature;
+}
+
+bool Message::isSigned() const {
+    for (uint8_t byte : signature) {
+        if (byte != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Message::getEncodedSize() const {
+    return HEADER_SIZE + payloadSize;
+}
+
+std::string Message::encode() const {
+    std::string out;
+    encodeTo(out);
+    return out;
+}
+
+void Message::encodeTo(std::string& out) const {
+    out.reserve(out.size() + getEncodedSize());
+    ByteWriter writer(out);
+    writer.writeU8(static_cast<uint8_t>(type));
+    writer.writeU64(height);
+    writer.writeU32(round);
+    writer.writeI32(senderId);
+    writer.writeBytes(blockHash.data(), Hash256::SIZE);
+    writer.writeBytes(signature.data(), signature.size());
+    writer.writeString(getPayload());
+}
+
+Message Message::decode(std::shared_ptr<const std::string> buffer) {
+    ByteReader reader(*buffer);
+    uint8_t type = reader.readU8();
+    if (type > TIMEOUT) {
+        throw std::runtime_error("Unknown message type.");
+    }
+    uint64_t height = reader.readU64();
+    uint32_t round = reader.readU32();
+    int senderId = reader.readI32();
+
+    Hash256 blockHash = Hash256::fromBytes(reader.readBytes(Hash256::SIZE).data());
+    Ed25519Signature signature;
+    std::string_view signatureBytes = reader.readBytes(signature.size());
+    std::copy(signatureBytes.begin(), signatureBytes.end(), signature.begin());
+
+    std::string_view payload = reader.readString();
+    if (!reader.atEnd()) {
+        throw std::runtime_error("Trailing bytes after message.");
+    }
+
+    Message message(static_cast<MessageType>(type), senderId, height, round, blockHash);
+    message.signature = signature;
+    if (!payload.empty()) {
+        message.payloadOffset = static_cast<size_t>(payload.data() - buffer->data());
+        message.payloadSize = payload.size();
+        message.payloadBuffer = std::move(buffer);
+    }
+    return message;
 }
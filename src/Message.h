@@ -1,27 +1,65 @@
 #ifndef MESSAGE_H
 #define MESSAGE_H
 
+#include "Hash256.h"
+#include "Ed25519.h"
 #include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
 
 enum MessageType {
     PROPOSAL,
     PREVOTE,
     PRECOMMIT,
-    ROLLBACK
+    ROLLBACK,
+    TIMEOUT   // Local timer firing, scheduled by the node itself
 };
 
+// Consensus message. The wire encoding is
+//   type u8 | height u64 | round u32 | sender i32 | block hash 32 bytes | signature 64 bytes | payload length u32 | payload
+// with little-endian integers. The sender's Ed25519 signature covers getSignBytes(); local
+// TIMEOUT messages are never signed. The payload (e.g. a serialized block) is reference-counted, so
+// copies of a broadcast share one buffer and decoding only takes a view into the input.
 class Message {
 public:
-    Message(MessageType type, int senderId, const std::string& content);
+    Message(MessageType type, int senderId, const std::string& content); // Content becomes the payload
+    Message(MessageType type, int senderId, uint64_t height, uint32_t round, const Hash256& blockHash,
+            std::shared_ptr<const std::string> payload = nullptr);
 
     MessageType getType() const;
     int getSenderId() const;
-    std::string getContent() const;
+    uint64_t getHeight() const;
+    uint32_t getRound() const;
+    const Hash256& getBlockHash() const;
+    std::string_view getPayload() const; // Empty when the message carries none
+    std::string toString() const;        // Short description for logs
+    static const char* getTypeName(MessageType type);
+
+    // Every field but the signature, with the payload replaced by its SHA-256 so signing cost
+    // does not grow with the block inside a proposal
+    std::string getSignBytes() const;
+    void setSignature(const Ed25519Signature& signature);
+    const Ed25519Signature& getSignature() const;
+    bool isSigned() const;
+
+    std::string encode() const;
+    void encodeTo(std::string& out) const;
+    size_t getEncodedSize() const;
+    static Message decode(std::shared_ptr<const std::string> buffer); // Payload stays a view into buffer
+
+    static const size_t HEADER_SIZE = 1 + 8 + 4 + 4 + 32 + 64 + 4;
 
 private:
     MessageType type;
     int senderId;
-    std::string content;
+    uint64_t height;
+    uint32_t round;
+    Hash256 blockHash;
+    Ed25519Signature signature; // All zero until signed
+    std::shared_ptr<const std::string> payloadBuffer; // Shared by every copy of the message
+    size_t payloadOffset;
+    size_t payloadSize;
 };
 
 #endif
@@ -0,0 +1,230 @@
+#include "Metrics.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::mutex Metrics::registryMutex;
+
+namespace {
+
+std::atomic<size_t> nextHistogramId(0);
+
+int highestBit(uint64_t value) {
+    int bit = 0;
+    for (int step = 32; step > 0; step >>= 1) {
+        if (value >> (bit + step)) {
+            bit += step;
+        }
+    }
+    return bit;
+}
+
+std::string familyOf(const std::string& name) {
+    return name.substr(0, name.find('{'));
+}
+
+// name{labels} with one more label added
+std::string withLabel(const std::string& name, const std::string& label) {
+    size_t brace = name.find('{');
+    if (brace == std::string::npos) {
+        return name + "{" + label + "}";
+    }
+    return name.substr(0, name.size() - 1) + "," + label + "}";
+}
+
+// name_suffix{labels}
+std::string withSuffix(const std::string& name, const std::string& suffix) {
+    size_t brace = name.find('{');
+    if (brace == std::string::npos) {
+        return name + suffix;
+    }
+    return name.substr(0, brace) + suffix + name.substr(brace);
+}
+
+} // namespace
+
+uint64_t HistogramSnapshot::percentile(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count)));
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t bound = Histogram::bucketUpperBound(i);
+            return bound < max ? bound : max;
+        }
+    }
+    return max;
+}
+
+Histogram::Histogram() : id(nextHistogramId.fetch_add(1)) {}
+
+size_t Histogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = highestBit(value);
+    int shift = exponent - SUB_BUCKET_BITS;
+    uint64_t subBucket = (value >> shift) - SUB_BUCKETS;
+    return static_cast<size_t>(SUB_BUCKETS + static_cast<uint64_t>(shift) * SUB_BUCKETS + subBucket);
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    uint64_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    uint64_t subBucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    uint64_t lower = (SUB_BUCKETS + subBucket) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+Histogram::Shard& Histogram::localShard() {
+    thread_local std::vector<Shard*> cache; // Indexed by histogram id
+    if (id < cache.size() && cache[id]) {
+        return *cache[id];
+    }
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    shards.push_back(std::make_unique<Shard>());
+    if (cache.size() <= id) {
+        cache.resize(id + 1, nullptr);
+    }
+    cache[id] = shards.back().get();
+    return *cache[id];
+}
+
+void Histogram::record(uint64_t value) {
+    // Only this thread writes the shard, so relaxed updates are enough and never contend
+    Shard& shard = localShard();
+    shard.counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+    if (value > shard.max.load(std::memory_order_relaxed)) {
+        shard.max.store(value, std::memory_order_relaxed);
+    }
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot merged;
+    merged.counts.assign(BUCKET_COUNT, 0);
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    for (const auto& shard : shards) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            uint64_t bucket = shard->counts[i].load(std::memory_order_relaxed);
+            merged.counts[i] += bucket;
+            merged.count += bucket;
+        }
+        merged.sum += shard->sum.load(std::memory_order_relaxed);
+        uint64_t max = shard->max.load(std::memory_order_relaxed);
+        if (max > merged.max) {
+            merged.max = max;
+        }
+    }
+    return merged;
+}
+
+std::map<std::string, Metrics::Entry>& Metrics::entries() {
+    static std::map<std::string, Entry> registered;
+    return registered;
+}
+
+Metrics::Entry& Metrics::entry(const std::string& name, const std::string& help, Kind kind) {
+    // Every series of a family must have the family's type
+    static std::map<std::string, Kind> familyKinds;
+    auto family = familyKinds.try_emplace(familyOf(name), kind).first;
+    if (family->second != kind) {
+        throw std::logic_error("Metric " + name + " is already registered with another type.");
+    }
+
+    auto inserted = entries().try_emplace(name);
+    Entry& found = inserted.first->second;
+    if (inserted.second) {
+        found.kind = kind;
+        found.help = help;
+        if (kind == Kind::COUNTER) {
+            found.counter = std::make_unique<Counter>();
+        } else if (kind == Kind::GAUGE) {
+            found.gauge = std::make_unique<Gauge>();
+        } else {
+            found.histogram = std::make_unique<Histogram>();
+        }
+    }
+    return found;
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return *entry(name, help, Kind::COUNTER).counter;
+}
+
+Gauge& Metrics::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return *entry(name, help, Kind::GAUGE).gauge;
+}
+
+Histogram& Metrics::histogram(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return *entry(name, help, Kind::HISTOGRAM).histogram;
+}
+
+void Metrics::writePrometheus(std::ostream& os) {
+    static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::string lastFamily;
+    for (const auto& named : entries()) {
+        const std::string& name = named.first;
+        const Entry& metric = named.second;
+        std::string family = familyOf(name);
+        if (family != lastFamily) {
+            const char* type = metric.kind == Kind::COUNTER ? "counter" : metric.kind == Kind::GAUGE ? "gauge" : "summary";
+            os << "# HELP " << family << " " << metric.help << "\n";
+            os << "# TYPE " << family << " " << type << "\n";
+            lastFamily = family;
+        }
+
+        if (metric.kind == Kind::COUNTER) {
+            os << name << " " << metric.counter->get() << "\n";
+        } else if (metric.kind == Kind::GAUGE) {
+            os << name << " " << metric.gauge->get() << "\n";
+        } else {
+            HistogramSnapshot snapshot = metric.histogram->snapshot();
+            for (double quantile : QUANTILES) {
+                std::ostringstream label;
+                label << "quantile=\"" << quantile << "\"";
+                os << withLabel(name, label.str()) << " " << snapshot.percentile(quantile) << "\n";
+            }
+            os << withSuffix(name, "_sum") << " " << snapshot.sum << "\n";
+            os << withSuffix(name, "_count") << " " << snapshot.count << "\n";
+        }
+    }
+}
+
+bool Metrics::writePrometheusFile(const std::string& path) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        writePrometheus(out);
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error); // Scrapers never see a half-written file
+    return !error;
+}
+
+uint64_t Metrics::nowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
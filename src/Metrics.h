@@ -0,0 +1,118 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class Counter {
+public:
+    void increment(uint64_t amount = 1) {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+class Gauge {
+public:
+    void set(int64_t newValue) {
+        value.store(newValue, std::memory_order_relaxed);
+    }
+    int64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> value{0};
+};
+
+// Merged view of a histogram at one point in time
+struct HistogramSnapshot {
+    std::vector<uint64_t> counts; // Per bucket
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    uint64_t percentile(double quantile) const; // Upper bound of the bucket holding it, 0 when empty
+};
+
+// Log-linear histogram in the style of HdrHistogram: every power of two is split into
+// SUB_BUCKETS equal buckets, so any value is recorded with at most 1/SUB_BUCKETS relative error.
+// Each thread records into its own shard without contention; snapshot() merges the shards.
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    Histogram();
+
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void record(uint64_t value);
+    HistogramSnapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index); // Largest value recorded into the bucket
+
+private:
+    struct Shard {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts{};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+    };
+
+    size_t id; // Index into each thread's shard cache, never reused
+    mutable std::mutex shardsMutex;
+    std::vector<std::unique_ptr<Shard>> shards; // Outlive their threads, so nothing recorded is lost
+
+    Shard& localShard();
+};
+
+// Process-wide registry of named metrics, scraped in the Prometheus text format. A name may carry
+// labels, as in messages_sent_total{type="prevote"}; everything before the brace is the family.
+// Look a metric up once and keep the reference: lookups take a lock, updates do not.
+class Metrics {
+public:
+    static Counter& counter(const std::string& name, const std::string& help);
+    static Gauge& gauge(const std::string& name, const std::string& help);
+    static Histogram& histogram(const std::string& name, const std::string& help); // Exported as a summary
+
+    static void writePrometheus(std::ostream& os);
+    static bool writePrometheusFile(const std::string& path); // Written aside and renamed into place
+
+    static uint64_t nowUs(); // Monotonic clock for timing code sections
+
+private:
+    enum class Kind {
+        COUNTER,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    struct Entry {
+        Kind kind;
+        std::string help;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    static std::mutex registryMutex;
+    static std::map<std::string, Entry>& entries();
+    static Entry& entry(const std::string& name, const std::string& help, Kind kind); // Caller holds registryMutex
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// Unbounded lock-free queue for many producers and a single consumer.
+// Producers only swap the head pointer, so posting never blocks; the owning
+// thread is the only one allowed to call pop() and empty().
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(new Cell()), tail(head.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        while (pop()) {
+        }
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Cell* cell = new Cell();
+        cell->value.emplace(std::move(value));
+        Cell* previous = head.exchange(cell, std::memory_order_acq_rel);
+        previous->next.store(cell, std::memory_order_release);
+    }
+
+    std::optional<T> pop() {
+        Cell* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(next->value));
+        next->value.reset();
+        delete tail;
+        tail = next; // next becomes the new stub
+        return value;
+    }
+
+    bool empty() const {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Cell {
+        std::atomic<Cell*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    std::atomic<Cell*> head; // Last pushed cell, shared by producers
+    Cell* tail;              // Stub before the oldest cell, owned by the consumer
+};
+
+#endif
@@ -1,20 +1,67 @@
 #include "Network.h"
 #include "Node.h" // Include the full definition
-#include "Utils.h"
+#include "Logger.h"
+#include "Config.h"
+#include "Metrics.h"
 #include <thread>
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+namespace {
+
+// Traffic counters per message type, registered once
+struct TrafficMetrics {
+    std::array<Counter*, TIMEOUT + 1> sent;
+    std::array<Counter*, TIMEOUT + 1> dropped;
+    std::array<Counter*, TIMEOUT + 1> delayed;
+    Histogram* delayMs;
+    Counter* deliveries;
+};
+
+const TrafficMetrics& trafficMetrics() {
+    static const TrafficMetrics metrics = [] {
+        TrafficMetrics created;
+        for (int type = PROPOSAL; type <= TIMEOUT; ++type) {
+            std::string name = Message::getTypeName(static_cast<MessageType>(type));
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            std::string label = "{type=\"" + name + "\"}";
+            created.sent[type] = &Metrics::counter("network_messages_sent_total" + label, "Messages scheduled for delivery");
+            created.dropped[type] = &Metrics::counter("network_messages_dropped_total" + label, "Delivery attempts lost to the simulated drop rate");
+            created.delayed[type] = &Metrics::counter("network_messages_delayed_total" + label, "Messages scheduled with a non-zero delay");
+        }
+        created.delayMs = &Metrics::histogram("network_delay_ms", "Simulated delay given to each message");
+        created.deliveries = &Metrics::counter("network_deliveries_total", "Messages and timers handed to nodes");
+        return created;
+    }();
+    return metrics;
+}
+
+} // namespace
 
 Network::Network() 
-    : messageDropRate(0.0), maxDelayMs(0), randomGenerator(std::random_device{}()) {}
+    : messageDropRate(0.0), maxDelayMs(0), randomGenerator(std::random_device{}()), stateMachine(nullptr),
+      mempool(Config::getMempoolCapacity()), currentTimeMs(0), clockMode(ClockMode::SIMULATED), nextSequence(0), dispatching(false),
+      executionMode(ExecutionMode::SINGLE_THREADED), pipelinedExecution(Config::isPipelinedExecution()), inFlight(0) {}
 
 Network::Network(StateMachine* stateMachine)
-    : messageDropRate(0.0), maxDelayMs(0), randomGenerator(std::random_device{}()), stateMachine(stateMachine) {}
+    : messageDropRate(0.0), maxDelayMs(0), randomGenerator(std::random_device{}()), stateMachine(stateMachine),
+      mempool(Config::getMempoolCapacity()), currentTimeMs(0), clockMode(ClockMode::SIMULATED), nextSequence(0), dispatching(false),
+      executionMode(ExecutionMode::SINGLE_THREADED), pipelinedExecution(Config::isPipelinedExecution()), inFlight(0) {}
 
 void Network::registerNode(Node* node) {
     nodes.push_back(node);
-    Utils::log("Node registered in the network.");
+    if (node) {
+        setVotingPower(node->getId(), Config::getDefaultVotingPower());
+        setPublicKey(node->getId(), node->getPublicKey());
+    }
+    if (executionMode == ExecutionMode::THREAD_PER_NODE && node) {
+        node->startWorker();
+    }
+    LOG_DEBUG("Node registered in the network.");
 }
 
 size_t Network::getTotalNodes() const {
@@ -22,21 +69,25 @@ size_t Network::getTotalNodes() const {
 }
 
 void Network::setMessageDropRate(double rate) {
-    // if (rate < 0.0 || rate > 1.0) {
-    //     Utils::log("Invalid message drop rate. Must be between 0.0 and 1.0.");
-    //     return;
-    // }
-    // messageDropRate = rate;
-    messageDropRate = 0.0; // Set to zero
+    if (!(rate >= 0.0 && rate <= 1.0)) {
+        LOG_WARN("Invalid message drop rate. Must be between 0.0 and 1.0.");
+        return;
+    }
+    std::lock_guard<std::mutex> lock(queueMutex);
+    messageDropRate = rate; // Each delivery gets up to three attempts, see broadcastMessage
 }
 
 void Network::setMaxDelayMs(int delayMs) {
-    // if (delayMs < 0) {
-    //     Utils::log("Invalid delay. Must be non-negative.");
-    //     return;
-    // }
-    // maxDelayMs = delayMs;
-    maxDelayMs = 0; // Set to zero
+    if (delayMs < 0) {
+        LOG_WARN("Invalid delay. Must be non-negative.");
+        return;
+    }
+    maxDelayMs = delayMs; // Delays only advance the virtual clock in simulated mode
+}
+
+void Network::setSeed(uint32_t seed) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    randomGenerator.seed(seed);
 }
 
 bool Network::shouldDropMessage() {
@@ -50,43 +101,288 @@ int Network::generateDelay() {
 }
 
 void Network::broadcastMessage(const Message& message) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    size_t scheduled = 0;
     for (Node* node : nodes) {
         if (node && node->getId() == message.getSenderId()) continue;
 
         if (!node) {
-            Utils::log("[ERROR] Null node encountered during broadcast.");
+            LOG_ERROR("Null node encountered during broadcast.");
             continue;
         }
 
         int attempts = 0;
         while (attempts < 3 && shouldDropMessage()) {
             attempts++;
-            Utils::log("Message dropped: " + message.getContent() + " to Node " + std::to_string(node->getId()));
+            trafficMetrics().dropped[message.getType()]->increment();
+            LOG_DEBUG("Message dropped: " + message.toString() + " to Node " + std::to_string(node->getId()));
         }
 
         if (attempts >= 3) continue;
 
-        int delay = generateDelay();
-        Utils::log("Message delayed by " + std::to_string(delay) + " ms to Node " + std::to_string(node->getId()));
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-        node->receiveMessage(message);
+        scheduleDelivery(node, message, generateDelay());
+        scheduled++;
+    }
+
+    LOG_TRACE("Network broadcast scheduled to " + std::to_string(scheduled) + " nodes for message: " + message.toString());
+}
+
+void Network::sendMessage(Node* recipient, const Message& message) {
+    if (!recipient) {
+        LOG_ERROR("Null node encountered during send.");
+        return;
+    }
+    std::lock_guard<std::mutex> lock(queueMutex);
+    scheduleDelivery(recipient, message, generateDelay());
+}
+
+void Network::scheduleDelivery(Node* recipient, const Message& message, int delayMs) {
+    LOG_TRACE("Message delayed by " + std::to_string(delayMs) + " ms to Node " + std::to_string(recipient->getId()));
+    const TrafficMetrics& traffic = trafficMetrics();
+    traffic.sent[message.getType()]->increment();
+    if (delayMs > 0) {
+        traffic.delayed[message.getType()]->increment();
+    }
+    traffic.delayMs->record(static_cast<uint64_t>(delayMs));
+    deliveryQueue.push({currentTimeMs + delayMs, nextSequence++, recipient, message});
+}
+
+uint64_t Network::scheduleTimeout(Node* node, int delayMs, const Message& timeout) {
+    if (!node) {
+        return 0;
+    }
+    // Timers are local to the node, so they are never dropped or delayed further
+    std::lock_guard<std::mutex> lock(queueMutex);
+    long long dueMs = currentTimeMs + delayMs;
+    return timers.schedule(dueMs, {dueMs, nextSequence++, node, timeout});
+}
+
+bool Network::cancelTimeout(uint64_t timerId) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return timers.cancel(timerId);
+}
+
+size_t Network::run() {
+    // Handlers broadcast while we are draining; those messages are simply queued
+    if (dispatching) {
+        return 0;
+    }
+    dispatching = true;
+
+    size_t delivered = 0;
+    std::vector<ScheduledDelivery> due;
+    std::vector<Node*> readyNodes;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (deliveryQueue.empty() && timers.empty()) {
+                break;
+            }
+
+            long long nextTimeMs = timers.nextDueMs();
+            if (!deliveryQueue.empty()) {
+                nextTimeMs = std::min(nextTimeMs, deliveryQueue.top().deliveryTimeMs);
+            }
+            if (nextTimeMs > currentTimeMs) {
+                if (clockMode == ClockMode::WALL_CLOCK) {
+                    // Wait only for the gap to the next delivery, not for every message's delay
+                    lock.unlock();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(nextTimeMs - currentTimeMs));
+                    lock.lock();
+                }
+                currentTimeMs = nextTimeMs;
+            }
+
+            // Take everything due at this instant
+            due.clear();
+            while (!deliveryQueue.empty() && deliveryQueue.top().deliveryTimeMs <= currentTimeMs) {
+                due.push_back(deliveryQueue.top());
+                deliveryQueue.pop();
+            }
+            size_t messageCount = due.size();
+            timers.popDue(currentTimeMs, due);
+            trafficMetrics().deliveries->increment(due.size());
+            if (messageCount != 0 && messageCount != due.size()) {
+                // Both kinds are due at once; keep scheduling order across them
+                std::inplace_merge(due.begin(), due.begin() + messageCount, due.end(),
+                                   [](const ScheduledDelivery& a, const ScheduledDelivery& b) { return a.sequence < b.sequence; });
+            }
+        }
+
+        if (executionMode == ExecutionMode::THREAD_PER_NODE) {
+            // Nodes handle this instant in parallel; the clock moves on once all of them are done
+            inFlight += due.size();
+            for (const ScheduledDelivery& delivery : due) {
+                delivery.recipient->postMessage(delivery.message);
+            }
+            waitForWorkers();
+            delivered += due.size();
+            continue;
+        }
+
+        readyNodes.clear();
+        for (const ScheduledDelivery& delivery : due) {
+            delivery.recipient->enqueueMessage(delivery.message);
+            if (std::find(readyNodes.begin(), readyNodes.end(), delivery.recipient) == readyNodes.end()) {
+                readyNodes.push_back(delivery.recipient);
+            }
+        }
+
+        for (Node* node : readyNodes) {
+            delivered += node->processInbox();
+        }
+    }
+
+    for (Node* node : nodes) {
+        if (node) {
+            node->waitForExecution(); // Callers expect the decided blocks to be in the chain and state
+        }
+    }
+    dispatching = false;
+    return delivered;
+}
+
+void Network::onMessageProcessed() {
+    if (inFlight.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idleCondition.notify_all();
+    }
+}
+
+void Network::waitForWorkers() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idleCondition.wait(lock, [this] { return inFlight.load() == 0; });
+}
+
+void Network::setExecutionMode(ExecutionMode mode) {
+    if (mode == executionMode) {
+        return;
     }
+    executionMode = mode;
+    for (Node* node : nodes) {
+        if (!node) continue;
+        if (mode == ExecutionMode::THREAD_PER_NODE) {
+            node->startWorker();
+        } else {
+            node->stopWorker();
+        }
+    }
+}
+
+ExecutionMode Network::getExecutionMode() const {
+    return executionMode;
+}
 
-    Utils::log("Network broadcast complete for message: " + message.getContent());
+void Network::setPipelinedExecution(bool enabled) {
+    pipelinedExecution = enabled;
+}
+
+bool Network::isPipelinedExecution() const {
+    return pipelinedExecution.load();
+}
+
+long long Network::getCurrentTimeMs() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return currentTimeMs;
+}
+
+void Network::setClockMode(ClockMode mode) {
+    clockMode = mode;
+}
+
+ClockMode Network::getClockMode() const {
+    return clockMode;
+}
+
+size_t Network::getPendingDeliveries() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return deliveryQueue.size() + timers.size();
 }
 
 void Network::addNode(Node* node) {
+    if (!node) {
+        LOG_ERROR("Cannot add a null node to the network.");
+        return;
+    }
     nodes.push_back(node);
+    setVotingPower(node->getId(), Config::getDefaultVotingPower());
+    setPublicKey(node->getId(), node->getPublicKey());
+    if (executionMode == ExecutionMode::THREAD_PER_NODE) {
+        node->startWorker();
+    }
     if (stateMachine) {
         stateMachine->prepareState({Transaction(0, node->getId(), 0)}); // Initialize the new node's balance
     }
-    Utils::log("Node " + std::to_string(node->getId()) + " added to the network.");
+    LOG_INFO("Node " + std::to_string(node->getId()) + " added to the network.");
 }
 
-void Network::addTransaction(const Transaction& transaction) {
-    globalPendingTransactions.push_back(transaction);
+bool Network::addTransaction(const Transaction& transaction) {
+    return mempool.addTransaction(transaction);
 }
 
 bool Network::hasPendingTransactions() const {
-    return !globalPendingTransactions.empty();
-}
\ No newline at end of file
+    return !mempool.empty();
+}
+
+Mempool& Network::getMempool() {
+    return mempool;
+}
+
+void Network::setVotingPower(int nodeId, uint64_t votingPower) {
+    std::lock_guard<std::mutex> lock(validatorMutex);
+    if (votingPower == 0) {
+        votingPowers.erase(nodeId);
+    } else {
+        votingPowers[nodeId] = votingPower;
+    }
+    pendingChanges.emplace_back(nodeId, votingPower);
+}
+
+ValidatorSet Network::getValidatorSet(uint64_t height) {
+    std::lock_guard<std::mutex> lock(validatorMutex);
+    if (votingPowers.empty() && validatorHistory.empty()) {
+        return ValidatorSet(); // Nobody registered yet; do not pin an empty set to this height
+    }
+
+    if (validatorHistory.empty()) {
+        // First request, possibly from a chain restored at a later height: rotate up to it one height at a time
+        ValidatorSet genesis;
+        genesis.update(std::vector<std::pair<int, uint64_t>>(votingPowers.begin(), votingPowers.end()));
+        pendingChanges.clear();
+        uint64_t first = std::max<uint64_t>(height, 1);
+        for (uint64_t h = 1; h <= first; ++h) {
+            genesis.incrementProposerPriority(1);
+        }
+        validatorHistory.emplace(first, std::move(genesis));
+    }
+
+    while (validatorHistory.rbegin()->first < height) {
+        ValidatorSet next = validatorHistory.rbegin()->second;
+        next.update(pendingChanges);
+        pendingChanges.clear();
+        next.incrementProposerPriority(1);
+        validatorHistory.emplace(validatorHistory.rbegin()->first + 1, std::move(next));
+        if (validatorHistory.size() > Config::getValidatorHistory()) {
+            validatorHistory.erase(validatorHistory.begin());
+        }
+    }
+
+    auto found = validatorHistory.find(height);
+    if (found == validatorHistory.end()) {
+        // Any other height's set may have different members or powers; checking against it would be unsafe
+        LOG_WARN("Validator set for height " + std::to_string(height) + " is no longer kept.");
+        return ValidatorSet();
+    }
+    return found->second;
+}
+
+void Network::setPublicKey(int nodeId, const Ed25519PublicKey& publicKey) {
+    std::lock_guard<std::mutex> lock(keysMutex);
+    publicKeys[nodeId] = std::make_shared<const Ed25519PublicKey>(publicKey);
+}
+
+std::shared_ptr<const Ed25519PublicKey> Network::getPublicKey(int nodeId) const {
+    std::lock_guard<std::mutex> lock(keysMutex);
+    auto found = publicKeys.find(nodeId);
+    return found == publicKeys.end() ? nullptr : found->second;
+}
@@ -4,12 +4,54 @@
 #include "Message.h"
 #include "Node.h"
 #include "StateMachine.h"
+#include "Mempool.h"
+#include "TimerWheel.h"
+#include "ValidatorSet.h"
+#include "Ed25519.h"
 #include <vector>
 #include <memory>
 #include <random>
+#include <queue>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <unordered_map>
+#include <utility>
 
 class Node; // Forward declaration
 
+// How the network clock advances between deliveries
+enum class ClockMode {
+    SIMULATED,  // Jump the virtual clock to the next delivery, delays cost no wall time
+    WALL_CLOCK  // Sleep until the next delivery, for interactive demos
+};
+
+// Where node message handlers run
+enum class ExecutionMode {
+    SINGLE_THREADED, // The delivery loop calls every handler itself
+    THREAD_PER_NODE  // Each node handles its mailbox on its own worker thread
+};
+
+// A message waiting in the network until its delivery time
+struct ScheduledDelivery {
+    long long deliveryTimeMs; // Virtual time (ms) at which the message reaches the recipient
+    uint64_t sequence;        // Tie-breaker so equal delivery times keep send order
+    Node* recipient;
+    Message message;
+};
+
+// Orders the delivery queue so the earliest delivery is on top
+struct LaterDelivery {
+    bool operator()(const ScheduledDelivery& a, const ScheduledDelivery& b) const {
+        if (a.deliveryTimeMs != b.deliveryTimeMs) {
+            return a.deliveryTimeMs > b.deliveryTimeMs;
+        }
+        return a.sequence > b.sequence;
+    }
+};
+
 class Network {
 public:
 
@@ -17,14 +59,42 @@ public:
     Network(StateMachine* stateMachine); // Update constructor to take StateMachine
 
     void registerNode(Node* node); // Register a node in the network
-    void broadcastMessage(const Message& message); // Broadcast a message to all nodes
+    void broadcastMessage(const Message& message); // Schedule a message for delivery to all other nodes
+    void sendMessage(Node* recipient, const Message& message); // Schedule a message for a single node
     void addNode(Node* node); // Add a dynamically created node to the network
+    uint64_t scheduleTimeout(Node* node, int delayMs, const Message& timeout); // Deliver a local timer message after delayMs virtual ms
+    bool cancelTimeout(uint64_t timerId); // False if it already fired
+
+    size_t run(); // Deliver scheduled messages until the network is idle, returns the number delivered
+    long long getCurrentTimeMs() const; // Current virtual time of the network
+    void setClockMode(ClockMode mode);
+    ClockMode getClockMode() const;
+    void setExecutionMode(ExecutionMode mode); // Starts or stops the node workers
+    ExecutionMode getExecutionMode() const;
+    // Pipelined: a node votes on the next height while its executor still stores and applies the
+    // last decided block. run() waits for the executors either way before it returns.
+    void setPipelinedExecution(bool enabled);
+    bool isPipelinedExecution() const;
+    void onMessageProcessed(); // Called by a node worker after handling one message
+    size_t getPendingDeliveries() const; // Messages and timers scheduled but not yet delivered
 
     void setMessageDropRate(double rate); // Set the message drop rate
     void setMaxDelayMs(int delayMs); // Set the maximum delay in ms
+    void setSeed(uint32_t seed); // Makes drops and delays repeatable; seeded randomly otherwise
     size_t getTotalNodes() const; // Get the total number of nodes
     bool hasPendingTransactions() const;
-    void addTransaction(const Transaction& transaction);
+    bool addTransaction(const Transaction& transaction); // Submit to the shared mempool
+    Mempool& getMempool();
+
+    // Registered nodes join the validator set with the default power. Changes take effect from the
+    // first height no node has asked for yet, so every node agrees on the set for a given height.
+    void setVotingPower(int nodeId, uint64_t votingPower); // 0 removes the node from the validator set
+    // Proposer for round 0 already chosen. Empty if nobody has registered yet or the height is older
+    // than the kept history.
+    ValidatorSet getValidatorSet(uint64_t height);
+
+    void setPublicKey(int nodeId, const Ed25519PublicKey& publicKey); // Registered nodes publish theirs automatically
+    std::shared_ptr<const Ed25519PublicKey> getPublicKey(int nodeId) const; // Null for unknown nodes
 
     const std::vector<Node*>& getNodes() const {
         return nodes;
@@ -36,10 +106,34 @@ private:
     int maxDelayMs; // Maximum network delay (in milliseconds)
     std::mt19937 randomGenerator; // Random number generator for network simulation
     StateMachine* stateMachine; // Pointer to the StateMachine
-    std::vector<Transaction> globalPendingTransactions;
+    Mempool mempool; // Transactions waiting for a block, shared by every proposer
+
+    std::priority_queue<ScheduledDelivery, std::vector<ScheduledDelivery>, LaterDelivery> deliveryQueue;
+    TimerWheel<ScheduledDelivery> timers; // Node timeouts, which are mostly cancelled before they fire
+    long long currentTimeMs; // Virtual clock, advanced by the delivery loop
+    ClockMode clockMode;     // Whether advancing the clock also waits in real time
+    uint64_t nextSequence;   // Sequence number for the next scheduled message
+    bool dispatching;        // True while run() is draining the queue
+    ExecutionMode executionMode;
+    std::atomic<bool> pipelinedExecution;
+
+    mutable std::mutex queueMutex;      // Guards deliveryQueue, timers, the clock and the RNG against worker threads
+    std::atomic<size_t> inFlight;       // Messages posted to workers and not yet handled
+    std::mutex idleMutex;
+    std::condition_variable idleCondition;
 
     bool shouldDropMessage(); // Decide whether to drop a message
     int generateDelay(); // Generate a random delay
+    void scheduleDelivery(Node* recipient, const Message& message, int delayMs); // Caller holds queueMutex
+    void waitForWorkers(); // Block until every posted message has been handled
+
+    std::mutex validatorMutex;
+    std::map<int, uint64_t> votingPowers;                  // Membership for heights not computed yet
+    std::vector<std::pair<int, uint64_t>> pendingChanges;  // Applied to the next height computed
+    std::map<uint64_t, ValidatorSet> validatorHistory;     // Recent heights, each derived from the one before
+
+    mutable std::mutex keysMutex;
+    std::unordered_map<int, std::shared_ptr<const Ed25519PublicKey>> publicKeys;
 };
 
 #endif
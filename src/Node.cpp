@@ -1,23 +1,121 @@
 #include "Node.h"
 #include "Utils.h"
+#include "Logger.h"
 #include <iostream>
 #include <sstream>
+#include <cstdio>
+#include <algorithm>
 
 Node::Node(int id, Network* network, StateMachine* stateMachine)
-    : id(id), network(network), stateMachine(stateMachine), consensus(this, stateMachine) {}
+    : id(id), network(network), consensus(this, stateMachine), stateMachine(stateMachine),
+      executor(this, stateMachine), nextNonce(0),
+      keyPair(Ed25519KeyPair::generate()), verifier(network, id), workerRunning(false) {}
+
+Node::~Node() {
+    stopWorker();
+}
 
 int Node::getId() const {
     return id;
 }
 
 void Node::receiveMessage(const Message& message) {
-    Utils::log("Node " + std::to_string(id) + " received message: " + message.getContent());
+    LOG_TRACE("Node " + std::to_string(id) + " received " + message.toString());
     consensus.onReceiveMessage(message);
 }
 
+void Node::enqueueMessage(const Message& message) {
+    inbox.push_back(message);
+}
+
+size_t Node::processInbox() {
+    size_t processed = 0;
+    std::vector<Message> batch;
+    while (!inbox.empty()) {
+        batch.assign(std::make_move_iterator(inbox.begin()), std::make_move_iterator(inbox.end()));
+        inbox.clear();
+        handleBatch(batch);
+        processed += batch.size();
+    }
+    return processed;
+}
+
+void Node::handleBatch(const std::vector<Message>& batch) {
+    std::vector<VerifyResult> results = verifier.verifyBatch(batch);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (results[i] == VerifyResult::VALID) {
+            receiveMessage(batch[i]);
+        } else if (results[i] == VerifyResult::CONFLICTING) {
+            LOG_WARN("Node " + std::to_string(id) + " caught Node " + std::to_string(batch[i].getSenderId()) +
+                       " signing two blocks: " + batch[i].toString());
+            consensus.reportEquivocation(batch[i].getSenderId());
+        } else if (results[i] == VerifyResult::STALE) {
+            LOG_TRACE("Node " + std::to_string(id) + " dropped " + batch[i].toString() + " for a decided height.");
+        } else {
+            LOG_WARN("Node " + std::to_string(id) + " dropped " + batch[i].toString() + ": missing or invalid signature.");
+        }
+    }
+    verifier.pruneBelow(consensus.getHeight());
+}
+
+void Node::startWorker() {
+    if (workerRunning.exchange(true)) {
+        return;
+    }
+    worker = std::thread(&Node::workerLoop, this);
+}
+
+void Node::stopWorker() {
+    if (!workerRunning.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+    worker.join();
+}
+
+bool Node::hasWorker() const {
+    return workerRunning.load();
+}
+
+void Node::postMessage(const Message& message) {
+    mailbox.push(message);
+    {
+        // Taking the lock orders the push before the worker's emptiness check, so no wakeup is lost
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void Node::workerLoop() {
+    std::vector<Message> batch;
+    while (true) {
+        // Take everything that arrived so its signatures are checked together
+        batch.clear();
+        while (auto message = mailbox.pop()) {
+            batch.push_back(std::move(*message));
+        }
+        if (!batch.empty()) {
+            handleBatch(batch);
+            for (size_t i = 0; i < batch.size() && network; ++i) {
+                network->onMessageProcessed();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this] { return !workerRunning.load() || !mailbox.empty(); });
+        if (!workerRunning.load() && mailbox.empty()) {
+            return;
+        }
+    }
+}
+
 void Node::proposeBlock() {
     // Node initiating block proposal
-    Utils::log("Node " + std::to_string(id) + " is proposing a new block.");
+    LOG_INFO("Node " + std::to_string(id) + " is proposing a new block.");
     consensus.startConsensus();  // Start the consensus process
 }
 
@@ -28,14 +126,92 @@ void Node::sendMessageToAll(const Message& message) {
 }
 
 void Node::rollbackConsensus() {
-    Utils::log("Node " + std::to_string(id) + " is rolling back consensus.");
+    LOG_INFO("Node " + std::to_string(id) + " is rolling back consensus.");
     consensus.rollbackConsensus();  
 }
 
+bool Node::recoverConsensus(const std::string& walPath) {
+    return consensus.recover(walPath);
+}
+
+bool Node::openStorage(const std::string& directory) {
+    if (!blockchain.open(directory)) {
+        return false;
+    }
+    loadOrCreateKey(directory + "/node.key");
+
+    // Start from the newest snapshot the chain covers and replay only the blocks after it. The next
+    // block carries the state root after the second-to-last one, so replay at least the last block.
+    int latest = blockchain.getChainLength() - 1;
+    int replayFrom = 1;
+    try {
+        snapshotStore = std::make_unique<SnapshotStore>(directory + "/snapshots");
+        if (stateMachine) {
+            replayFrom = static_cast<int>(snapshotStore->loadLatest(*stateMachine, static_cast<uint64_t>(std::max(latest - 1, 0)))) + 1;
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN("State snapshots unavailable under " + directory + ": " + e.what());
+    }
+    if (stateMachine) {
+        if (replayFrom > 1 && replayFrom - 1 >= latest - 1) {
+            executor.recordAppHash(static_cast<uint64_t>(replayFrom - 1), stateMachine->getStateRoot());
+        }
+        for (int height = replayFrom; height <= latest; ++height) {
+            stateMachine->prepareState(blockchain.getBlock(height)->getTransactions());
+            stateMachine->commitState();
+            if (height >= latest - 1) {
+                executor.recordAppHash(static_cast<uint64_t>(height), stateMachine->getStateRoot());
+            }
+        }
+        LOG_INFO("Node " + std::to_string(id) + " replayed " + std::to_string(blockchain.getChainLength() - replayFrom) + " blocks into its state.");
+    }
+
+    bool recovered = consensus.recover(directory + "/consensus.wal");
+    if (stateMachine) {
+        // Restarting from 0 would reuse the hashes of transfers this node already committed
+        nextNonce = std::max(nextNonce, stateMachine->getNonce(id));
+    }
+    return recovered;
+}
+
+void Node::loadOrCreateKey(const std::string& path) {
+    // Votes in the WAL are re-sent after a restart, so they must still verify under the same key
+    std::array<uint8_t, Ed25519KeyPair::SEED_SIZE> seed{};
+    bool needWrite = true;
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        bool complete = std::fread(seed.data(), 1, seed.size(), file) == seed.size();
+        std::fclose(file);
+        if (complete) {
+            keyPair = Ed25519KeyPair::fromSeed(seed);
+            needWrite = false;
+        } else {
+            LOG_WARN("Key file " + path + " is truncated. Keeping a new key.");
+        }
+    }
+    if (needWrite) {
+        seed = keyPair.getSeed();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            LOG_WARN("Cannot store the node key in " + path + ". It will change on restart.");
+        } else {
+            bool written = std::fwrite(seed.data(), 1, seed.size(), file) == seed.size() && Utils::syncFile(file);
+            std::fclose(file);
+            if (!written) {
+                LOG_WARN("Cannot write the node key to " + path + ". It will change on restart.");
+            }
+        }
+    }
+    if (network) {
+        network->setPublicKey(id, keyPair.getPublicKey());
+    }
+}
+
 void Node::printStatus(std::ostream& os) const {
     os << "Node ID: " << id << std::endl;
     os << "Blockchain length: " << blockchain.getChainLength() << std::endl;
     os << "Consensus stage: " << consensus.getCurrentStageAsString() << std::endl;
+    os << "Consensus height/round: " << consensus.getHeight() << "/" << consensus.getRound() << std::endl;
 
     if (stateMachine) {
         double balance = stateMachine->getBalance(id);
@@ -45,37 +221,44 @@ void Node::printStatus(std::ostream& os) const {
     }
 
     os << "Pending transactions: " << std::endl;
-    for (const auto& tx : pendingTransactions) {
+    for (const auto& tx : getPendingTransactions()) {
         os << "  - " << tx.toString() << std::endl;
     }
 }
 
-void Node::createTransaction(int receiverId, double amount) {
+void Node::createTransaction(int receiverId, double amount, double fee) {
     if (stateMachine->getBalance(this->id) < amount) {
-        Utils::log("Transaction failed: insufficient balance.");
+        LOG_WARN("Transaction failed: insufficient balance.");
+        return;
+    }
+    if (!network) {
+        LOG_WARN("Transaction failed: node is not connected to a network.");
         return;
     }
 
-    Transaction transaction(this->id, receiverId, amount);
-    pendingTransactions.push_back(transaction);
-    Utils::log("Transaction created: " + transaction.toString());
-
-    // Directly add transaction to Consensus
-    consensus.addPendingTransaction(transaction);
+    Transaction transaction(this->id, receiverId, amount, nextNonce++, fee);
+    if (network->addTransaction(transaction)) {
+        LOG_DEBUG("Transaction created: " + transaction.toString());
+    }
 }
 
+std::vector<Transaction> Node::getPendingTransactions() const {
+    if (!network) {
+        return {};
+    }
+    return network->getMempool().getTransactions();
+}
 
+SnapshotStore* Node::getSnapshotStore() {
+    return snapshotStore.get();
+}
 
-const std::vector<Transaction>& Node::getPendingTransactions() const {
-    return pendingTransactions;
+BlockExecutor& Node::getExecutor() {
+    return executor;
 }
 
-void Node::clearPendingTransactions() {
-    if (consensus.getCurrentStageAsString() == "FINALIZED") {
-        pendingTransactions.clear();
-    } else {
-        Utils::log("Transactions not cleared: Consensus is not finalized.");
-    }
+void Node::waitForExecution() {
+    executor.waitIdle();
 }
 
 Blockchain& Node::getBlockchain() {
@@ -84,4 +267,16 @@ Blockchain& Node::getBlockchain() {
 
 Network* Node::getNetwork() const {
     return network;
-}
\ No newline at end of file
+}
+
+const Ed25519PublicKey& Node::getPublicKey() const {
+    return keyPair.getPublicKey();
+}
+
+void Node::signMessage(Message& message) const {
+    message.setSignature(keyPair.sign(message.getSignBytes()));
+}
+
+const SignatureVerifier& Node::getVerifier() const {
+    return verifier;
+}
@@ -6,29 +6,55 @@
 #include "Message.h"
 #include "Consensus.h"
 #include "StateMachine.h"
+#include "MpscQueue.h"
+#include "SnapshotStore.h"
+#include "Ed25519.h"
+#include "SignatureVerifier.h"
+#include "BlockExecutor.h"
 #include <string>
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 class Network; // Forward declaration to avoid circular dependency
 
 class Node {
 public:
     Node(int id, Network* network, StateMachine* stateMachine);
+    ~Node();
 
     int getId() const;
-    void receiveMessage(const Message& message);
+    void receiveMessage(const Message& message); // Trusted: signatures are checked by processInbox and the worker
+    void enqueueMessage(const Message& message); // Queue a delivered message for later processing
+    size_t processInbox(); // Verify and handle all queued messages, returns the number processed
+
+    void startWorker(); // Handle messages on a dedicated thread from now on
+    void stopWorker();  // Join the worker thread once its mailbox is drained
+    void postMessage(const Message& message); // Hand a message to the worker, callable from any thread
+    bool hasWorker() const;
     void proposeBlock();
     void handleConsensus();
     void sendMessageToAll(const Message& message);
     void rollbackConsensus();
+    bool recoverConsensus(const std::string& walPath); // Replay and keep using a consensus write-ahead log
+    // Keep chain, state snapshots and consensus WAL under directory, restoring whatever an earlier run left there
+    bool openStorage(const std::string& directory);
     void printStatus(std::ostream& os = std::cout) const;
 
-    void createTransaction(int receiverId, double amount);
-    const std::vector<Transaction>& getPendingTransactions() const;
-    void clearPendingTransactions();
+    void createTransaction(int receiverId, double amount, double fee = 0.0);
+    std::vector<Transaction> getPendingTransactions() const; // Snapshot of the network mempool
     Blockchain& getBlockchain();
+    SnapshotStore* getSnapshotStore(); // Null while the node runs without storage
+    BlockExecutor& getExecutor();
+    void waitForExecution(); // Block until every decided block is stored and applied
     Network* getNetwork() const;
+    const Ed25519PublicKey& getPublicKey() const;
+    void signMessage(Message& message) const;
+    const SignatureVerifier& getVerifier() const;
 
 private:
     int id;
@@ -37,7 +63,22 @@ private:
     Consensus consensus; // Ensure 'Consensus' is fully defined in the header
     
     StateMachine* stateMachine;
-    std::vector<Transaction> pendingTransactions;
+    std::unique_ptr<SnapshotStore> snapshotStore;
+    BlockExecutor executor; // After the chain and snapshot store it writes to, so it stops first
+    uint64_t nextNonce; // Nonce for the next transaction this node signs
+    Ed25519KeyPair keyPair; // Random until openStorage loads or stores the node's key
+    SignatureVerifier verifier;
+    std::deque<Message> inbox; // Messages delivered by the network but not yet handled
+
+    MpscQueue<Message> mailbox;       // Lock-free inbox used when the node runs its own worker
+    std::thread worker;
+    std::atomic<bool> workerRunning;
+    std::mutex wakeMutex;             // Only guards sleeping, never the mailbox itself
+    std::condition_variable wakeCondition;
+
+    void workerLoop();
+    void handleBatch(const std::vector<Message>& batch); // Verify all signatures, then handle what passed
+    void loadOrCreateKey(const std::string& path);
 
     void processProposal(const Message& message);
 };
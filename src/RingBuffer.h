@@ -0,0 +1,80 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <cstddef>
+
+// Bounded lock-free queue for many producers and a single consumer. Each slot carries a sequence
+// number that tells producers whether it is free and the consumer whether it is filled, so a push
+// is one compare-and-swap on the write position and never allocates. push() fails instead of
+// waiting when the ring is full. Only the owning thread may call pop().
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity) : mask(roundUp(capacity) - 1), slots(new Slot[mask + 1]), writePos(0), readPos(0) {
+        for (size_t i = 0; i <= mask; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    bool push(T value) {
+        size_t position = writePos.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[position & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == position) {
+                if (writePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < position) {
+                return false; // The consumer has not freed this slot yet
+            } else {
+                position = writePos.load(std::memory_order_relaxed); // Another producer took it
+            }
+        }
+    }
+
+    std::optional<T> pop() {
+        Slot& slot = slots[readPos & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != readPos + 1) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(slot.value));
+        slot.sequence.store(readPos + mask + 1, std::memory_order_release);
+        ++readPos;
+        return value;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> writePos; // Shared by producers
+    size_t readPos;               // Owned by the consumer
+
+    static size_t roundUp(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// Little-endian stores into a caller-provided buffer, for fixed-size encodings
+inline void storeU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+inline void storeU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+inline void storeF64(uint8_t* out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    storeU64(out, bits);
+}
+
+// Appends fixed-width little-endian fields to a byte string
+class ByteWriter {
+public:
+    explicit ByteWriter(std::string& out) : out(out) {}
+
+    void writeU8(uint8_t value) {
+        out.push_back(static_cast<char>(value));
+    }
+
+    void writeU32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void writeU64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void writeI32(int32_t value) {
+        writeU32(static_cast<uint32_t>(value));
+    }
+
+    void writeI64(int64_t value) {
+        writeU64(static_cast<uint64_t>(value));
+    }
+
+    void writeF64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeU64(bits);
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    void writeString(std::string_view value) { // Length-prefixed
+        writeU32(static_cast<uint32_t>(value.size()));
+        out.append(value.data(), value.size());
+    }
+
+private:
+    std::string& out;
+};
+
+// Reads fields written by ByteWriter, throwing std::runtime_error on truncated input
+class ByteReader {
+public:
+    explicit ByteReader(std::string_view data) : data(data), position(0) {}
+
+    uint8_t readU8() {
+        require(1);
+        return static_cast<uint8_t>(data[position++]);
+    }
+
+    uint32_t readU32() {
+        require(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(data[position++])) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t readU64() {
+        require(8);
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data[position++])) << (8 * i);
+        }
+        return value;
+    }
+
+    int32_t readI32() {
+        return static_cast<int32_t>(readU32());
+    }
+
+    int64_t readI64() {
+        return static_cast<int64_t>(readU64());
+    }
+
+    double readF64() {
+        uint64_t bits = readU64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string_view readBytes(size_t size) { // View into the input, no copy
+        require(size);
+        std::string_view bytes = data.substr(position, size);
+        position += size;
+        return bytes;
+    }
+
+    std::string_view readString() {
+        return readBytes(readU32());
+    }
+
+    size_t getPosition() const {
+        return position;
+    }
+
+    bool atEnd() const {
+        return position == data.size();
+    }
+
+private:
+    std::string_view data;
+    size_t position;
+
+    void require(size_t size) const {
+        if (data.size() - position < size) {
+            throw std::runtime_error("Truncated binary input.");
+        }
+    }
+};
+
+#endif
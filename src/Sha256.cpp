@@ -0,0 +1,58 @@
+#include "Sha256.h"
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
+#include <stdexcept>
+
+namespace {
+// Fetched once; passing EVP_sha256() to every init makes OpenSSL 3 look the algorithm up again
+const EVP_MD* sha256Algorithm() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static const EVP_MD* algorithm = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+#else
+    static const EVP_MD* algorithm = EVP_sha256();
+#endif
+    return algorithm;
+}
+
+// Per-thread context for one-shot digests, so hashing many small inputs allocates nothing
+EVP_MD_CTX* threadContext() {
+    thread_local struct Holder {
+        EVP_MD_CTX* context = EVP_MD_CTX_new();
+        ~Holder() { EVP_MD_CTX_free(context); }
+    } holder;
+    return holder.context;
+}
+}
+
+Sha256::Sha256() : context(EVP_MD_CTX_new()) {
+    if (!context || EVP_DigestInit_ex(context, sha256Algorithm(), nullptr) != 1) {
+        EVP_MD_CTX_free(context);
+        throw std::runtime_error("Failed to initialize SHA-256 context.");
+    }
+}
+
+Sha256::~Sha256() {
+    EVP_MD_CTX_free(context);
+}
+
+void Sha256::update(const void* data, size_t size) {
+    EVP_DigestUpdate(context, data, size);
+}
+
+Hash256 Sha256::finish() {
+    Hash256 hash;
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(context, hash.data(), &length);
+    EVP_DigestInit_ex(context, sha256Algorithm(), nullptr);
+    return hash;
+}
+
+Hash256 Sha256::digest(const void* data, size_t size) {
+    Hash256 hash;
+    unsigned int length = 0;
+    EVP_MD_CTX* context = threadContext();
+    EVP_DigestInit_ex(context, sha256Algorithm(), nullptr);
+    EVP_DigestUpdate(context, data, size);
+    EVP_DigestFinal_ex(context, hash.data(), &length);
+    return hash;
+}
@@ -0,0 +1,28 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include "Hash256.h"
+#include <cstddef>
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+// Incremental SHA-256 over an OpenSSL EVP context, so callers can hash
+// structured data field by field without building an intermediate string.
+class Sha256 {
+public:
+    Sha256();
+    ~Sha256();
+
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void update(const void* data, size_t size);
+    Hash256 finish(); // Returns the digest and resets the context for reuse
+
+    static Hash256 digest(const void* data, size_t size); // One-shot, no context allocation
+
+private:
+    EVP_MD_CTX* context;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "SignatureVerifier.h"
+#include "Network.h"
+#include "ThreadPool.h"
+#include "Sha256.h"
+
+SignatureVerifier::SignatureVerifier(Network* network, int localId)
+    : network(network), localId(localId), prunedBelow(0), signatureChecks(0) {}
+
+std::vector<VerifyResult> SignatureVerifier::verifyBatch(const std::vector<Message>& messages) {
+    std::vector<VerifyResult> results(messages.size(), VerifyResult::INVALID);
+    std::vector<size_t> pending;
+    std::vector<std::shared_ptr<const Ed25519PublicKey>> keys(messages.size());
+    std::vector<std::string> signBytes(messages.size());
+    std::vector<Hash256> digests(messages.size());
+
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const Message& message = messages[i];
+        if (message.getType() == TIMEOUT) {
+            // Timers are local; one claiming to come from elsewhere is forged
+            results[i] = message.getSenderId() == localId ? VerifyResult::VALID : VerifyResult::INVALID;
+            continue;
+        }
+        if (message.getHeight() < prunedBelow) {
+            results[i] = VerifyResult::STALE; // Nothing to act on, so not worth a signature check
+            continue;
+        }
+        if (!message.isSigned() || !network) {
+            continue;
+        }
+        signBytes[i] = message.getSignBytes();
+        digests[i] = Sha256::digest(signBytes[i].data(), signBytes[i].size());
+        auto found = verified.find({message.getSenderId(), message.getHeight(), message.getRound(), message.getType()});
+        if (found != verified.end() && found->second.signature == message.getSignature() &&
+            found->second.payloadDigest == digests[i]) {
+            results[i] = VerifyResult::VALID; // A copy we already checked
+            continue;
+        }
+        keys[i] = network->getPublicKey(message.getSenderId());
+        if (keys[i]) {
+            pending.push_back(i);
+        }
+    }
+
+    std::vector<uint8_t> valid(pending.size(), 0);
+    auto check = [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            const Message& message = messages[pending[k]];
+            valid[k] = keys[pending[k]]->verify(signBytes[pending[k]], message.getSignature()) ? 1 : 0;
+        }
+    };
+    if (pending.size() >= PARALLEL_BATCH_THRESHOLD) {
+        ThreadPool::shared().parallelFor(pending.size(), 2, check);
+    } else {
+        check(0, pending.size());
+    }
+    signatureChecks += pending.size();
+
+    // Record in arrival order, so of two conflicting messages in one batch the first one stands
+    for (size_t k = 0; k < pending.size(); ++k) {
+        if (!valid[k]) {
+            continue;
+        }
+        const Message& message = messages[pending[k]];
+        Slot slot{message.getSenderId(), message.getHeight(), message.getRound(), message.getType()};
+        auto found = verified.find(slot);
+        if (found != verified.end() && found->second.blockHash != message.getBlockHash()) {
+            results[pending[k]] = VerifyResult::CONFLICTING;
+            continue;
+        }
+        verified[slot] = {message.getBlockHash(), digests[pending[k]], message.getSignature()};
+        results[pending[k]] = VerifyResult::VALID;
+    }
+    return results;
+}
+
+void SignatureVerifier::pruneBelow(uint64_t height) {
+    if (height <= prunedBelow) {
+        return;
+    }
+    prunedBelow = height;
+    for (auto it = verified.begin(); it != verified.end();) {
+        if (it->first.height < height) {
+            it = verified.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t SignatureVerifier::getCacheSize() const {
+    return verified.size();
+}
+
+uint64_t SignatureVerifier::getSignatureChecks() const {
+    return signatureChecks;
+}
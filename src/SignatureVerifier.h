@@ -0,0 +1,71 @@
+#ifndef SIGNATURE_VERIFIER_H
+#define SIGNATURE_VERIFIER_H
+
+#include "Message.h"
+#include "Ed25519.h"
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+class Network;
+
+enum class VerifyResult {
+    VALID,
+    INVALID,     // Unsigned, unknown sender or bad signature; the claimed sender proves nothing
+    CONFLICTING, // Correctly signed, but the sender already signed a different block for this slot
+    STALE        // For a height already decided; not checked, so it proves nothing and must be dropped
+};
+
+// Checks the signatures on a node's incoming messages. A batch is verified on the shared thread
+// pool, and every verified (sender, height, round, type) is remembered with a digest of its signed
+// bytes and its signature: a re-sent copy costs a hash and a lookup instead of a signature check, and a second signed
+// block for the same slot is caught as equivocation. Used by one node's handler at a time.
+class SignatureVerifier {
+public:
+    SignatureVerifier(Network* network, int localId);
+
+    std::vector<VerifyResult> verifyBatch(const std::vector<Message>& messages);
+    void pruneBelow(uint64_t height); // Forget slots of heights that are decided
+
+    size_t getCacheSize() const;
+    uint64_t getSignatureChecks() const; // Signatures actually verified, cache hits excluded
+
+    static const size_t PARALLEL_BATCH_THRESHOLD = 8; // Fewer checks than this are not worth waking the pool
+
+private:
+    struct Slot {
+        int senderId;
+        uint64_t height;
+        uint32_t round;
+        MessageType type;
+
+        bool operator==(const Slot& other) const {
+            return senderId == other.senderId && height == other.height && round == other.round && type == other.type;
+        }
+    };
+
+    struct SlotHash {
+        size_t operator()(const Slot& slot) const noexcept {
+            size_t value = std::hash<uint64_t>()(slot.height);
+            value = value * 31 + std::hash<uint32_t>()(slot.round);
+            value = value * 31 + std::hash<int>()(slot.senderId);
+            return value * 31 + static_cast<size_t>(slot.type);
+        }
+    };
+
+    struct Verified {
+        Hash256 blockHash;
+        Hash256 payloadDigest; // Of everything the signature covers, so a copy must match in every signed field
+        Ed25519Signature signature;
+    };
+
+    Network* network;
+    int localId;
+    std::unordered_map<Slot, Verified, SlotHash> verified;
+    uint64_t prunedBelow;
+    uint64_t signatureChecks;
+};
+
+#endif
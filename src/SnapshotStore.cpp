@@ -0,0 +1,91 @@
+#include "SnapshotStore.h"
+#include "MappedFile.h"
+#include "Utils.h"
+#include "Logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+SnapshotStore::SnapshotStore(const std::string& directory, size_t retained, FsyncPolicy fsyncPolicy)
+    : directory(directory), retained(std::max<size_t>(retained, 1)), fsyncPolicy(fsyncPolicy) {
+    fs::create_directories(directory);
+}
+
+void SnapshotStore::save(const StateMachine& stateMachine, uint64_t height) {
+    std::string bytes;
+    stateMachine.encodeSnapshot(bytes, height);
+
+    std::string path = snapshotPath(height);
+    std::string temporaryPath = path + ".tmp";
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot create " + temporaryPath);
+    }
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && std::fflush(file) == 0;
+    if (written && fsyncPolicy != FsyncPolicy::NEVER) {
+        written = Utils::syncFile(file); // The rename must not become durable before the contents
+    }
+    written = std::fclose(file) == 0 && written;
+    if (!written) {
+        fs::remove(temporaryPath);
+        throw std::runtime_error("Cannot write " + temporaryPath);
+    }
+    fs::rename(temporaryPath, path);
+    if (fsyncPolicy != FsyncPolicy::NEVER && !Utils::syncDirectory(directory)) {
+        throw std::runtime_error("Cannot sync " + directory);
+    }
+    LOG_INFO("State snapshot for height " + std::to_string(height) + " written to " + path);
+
+    std::vector<uint64_t> heights = getHeights();
+    for (size_t i = 0; i + retained < heights.size(); ++i) {
+        fs::remove(snapshotPath(heights[i]));
+    }
+}
+
+uint64_t SnapshotStore::loadLatest(StateMachine& stateMachine, uint64_t maxHeight) const {
+    std::vector<uint64_t> heights = getHeights();
+    for (auto it = heights.rbegin(); it != heights.rend(); ++it) {
+        if (*it > maxHeight) {
+            continue; // Newer than the chain we recovered
+        }
+        try {
+            MappedFile file;
+            file.open(snapshotPath(*it));
+            std::string_view bytes = file.view(0, file.size());
+            // Checked first, so a mislabelled file never replaces the state
+            if (StateMachine::readSnapshotHeight(bytes) != *it) {
+                throw std::runtime_error("file name and contents disagree on the height");
+            }
+            uint64_t height = stateMachine.restoreSnapshot(bytes);
+            LOG_INFO("Loaded state snapshot for height " + std::to_string(height));
+            return height;
+        } catch (const std::exception& e) {
+            LOG_WARN("Skipping state snapshot " + snapshotPath(*it) + ": " + e.what());
+        }
+    }
+    return 0;
+}
+
+std::vector<uint64_t> SnapshotStore::getHeights() const {
+    std::vector<uint64_t> heights;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        unsigned long long height;
+        char tail;
+        if (std::sscanf(name.c_str(), "state-%llu.sna%c", &height, &tail) == 2 && tail == 'p' &&
+            name == fs::path(snapshotPath(height)).filename().string()) {
+            heights.push_back(height);
+        }
+    }
+    std::sort(heights.begin(), heights.end());
+    return heights;
+}
+
+std::string SnapshotStore::snapshotPath(uint64_t height) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "state-%012llu.snap", static_cast<unsigned long long>(height));
+    return (fs::path(directory) / name).string();
+}
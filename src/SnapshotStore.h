@@ -0,0 +1,34 @@
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#include "StateMachine.h"
+#include "Config.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Directory of state snapshots named state-<height>.snap. Files are written under a temporary
+// name and renamed once written, so a crash never leaves a half-written snapshot behind, and
+// only the newest few are kept. Unless the fsync policy is NEVER, the contents are synced before
+// the rename and the directory after it.
+class SnapshotStore {
+public:
+    // Throws std::filesystem::filesystem_error
+    explicit SnapshotStore(const std::string& directory, size_t retained = 2,
+                           FsyncPolicy fsyncPolicy = Config::getFsyncPolicy());
+
+    void save(const StateMachine& stateMachine, uint64_t height); // Throws std::runtime_error
+    // Loads the newest readable snapshot at or below maxHeight into stateMachine and returns its
+    // height, skipping any that fail verification. Returns 0 and leaves the state alone if none fits.
+    uint64_t loadLatest(StateMachine& stateMachine, uint64_t maxHeight) const;
+    std::vector<uint64_t> getHeights() const; // Ascending
+
+private:
+    std::string directory;
+    size_t retained;
+    FsyncPolicy fsyncPolicy;
+
+    std::string snapshotPath(uint64_t height) const;
+};
+
+#endif
@@ -1,105 +1,392 @@
 #include "StateMachine.h"
-#include "Utils.h"
-#include <iostream>
+#include "Logger.h"
+#include "ThreadPool.h"
+#include "Serialization.h"
+#include "Sha256.h"
+#include <algorithm>
+#include <atomic>
 
-StateMachine::StateMachine() {
+StateMachine::StateMachine() : hasPendingState(false) {
     // 初始化节点的账户余额
-    balances[1] = 1000.0;
-    balances[2] = 1000.0;
-    balances[3] = 1000.0;
-    balances[4] = 1000.0;
+    for (int nodeId = 1; nodeId <= 4; ++nodeId) {
+        setAccount(accounts.slotFor(nodeId), AccountStore::toAmount(1000.0), 0);
+    }
 }
 
 void StateMachine::applyTransactions(const std::vector<Transaction>& transactions) {
+    std::lock_guard<std::mutex> lock(stateMutex);
     try {
         for (const auto& tx : transactions) {
-            if (balances[tx.getSenderId()] >= tx.getAmount()) {
-                balances[tx.getSenderId()] -= tx.getAmount();
-                balances[tx.getReceiverId()] += tx.getAmount();
+            uint32_t sender = accounts.slotFor(tx.getSenderId());
+            Amount amount = AccountStore::toAmount(tx.getAmount());
+            if (accounts.getBalance(sender) >= amount) {
+                uint64_t nonce = std::max(accounts.getNonce(sender), tx.getNonce() + 1);
+                writeAccount(sender, accounts.getBalance(sender) - amount, nonce);
+                uint32_t receiver = accounts.slotFor(tx.getReceiverId());
+                writeAccount(receiver, accounts.getBalance(receiver) + amount, accounts.getNonce(receiver));
             } else {
-                Utils::log("Transaction failed: insufficient balance for sender " + std::to_string(tx.getSenderId()));
+                LOG_WARN("Transaction failed: insufficient balance for sender " + std::to_string(tx.getSenderId()));
                 throw std::runtime_error("Transaction failed: insufficient balance.");
             }
         }
     } catch (const std::exception& e) {
-        Utils::log("Transaction processing error: " + std::string(e.what()));
+        LOG_WARN("Transaction processing error: " + std::string(e.what()));
         throw; // Ensure rollback is triggered
     }
 }
 
 void StateMachine::prepareState(const std::vector<Transaction>& transactions) {
-    pendingBalances = balances; // Copy current state to pending state
+    std::lock_guard<std::mutex> lock(stateMutex);
+    // Only touched accounts go into the overlay; untouched ones are read through to accounts
+    clearPending();
+    hasPendingState = true;
+    if (transactions.size() >= PARALLEL_EXECUTION_THRESHOLD) {
+        if (prepareParallel(transactions)) {
+            LOG_DEBUG("Transactions prepared successfully.");
+        }
+        return;
+    }
     for (const auto& tx : transactions) {
-        int sender = tx.getSenderId();
-        int receiver = tx.getReceiverId();
-        double amount = tx.getAmount();
+        uint32_t sender = touchPending(tx.getSenderId());
+        uint32_t receiver = touchPending(tx.getReceiverId());
+        Amount amount = AccountStore::toAmount(tx.getAmount());
 
         if (pendingBalances[sender] < amount) {
-            Utils::log("Transaction preparation failed: insufficient balance for sender " + std::to_string(sender));
+            LOG_WARN("Transaction preparation failed: insufficient balance for sender " + std::to_string(tx.getSenderId()));
             return; // Log failure and exit the function without committing changes
         }
         pendingBalances[sender] -= amount;
         pendingBalances[receiver] += amount;
+        pendingNonces[sender] = std::max(pendingNonces[sender], tx.getNonce() + 1);
     }
-    Utils::log("Transactions prepared successfully.");
+    LOG_DEBUG("Transactions prepared successfully.");
 }
 
 
+// A transfer reads and writes exactly its sender and receiver, so conflicts are known before
+// running anything: a transaction conflicts if an earlier one in the block touches either account.
+// Conflict-free transactions are spread over the thread pool (no two of them share an account),
+// then the conflicting ones are re-executed in block order on top of those results. The outcome,
+// including where a failing block stops, is identical to the sequential loop.
+bool StateMachine::prepareParallel(const std::vector<Transaction>& transactions) {
+    size_t count = transactions.size();
+    std::vector<uint32_t> senders(count);
+    std::vector<uint32_t> receivers(count);
+    std::vector<uint8_t> conflicts(count);
+    std::vector<size_t> touchedAfter(count); // touchedSlots.size() once transaction i has touched its accounts
+
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t sender = accounts.slotFor(transactions[i].getSenderId());
+        uint32_t receiver = accounts.slotFor(transactions[i].getReceiverId());
+        conflicts[i] = (sender < pendingTouched.size() && pendingTouched[sender]) ||
+                       (receiver < pendingTouched.size() && pendingTouched[receiver]);
+        senders[i] = touchPending(transactions[i].getSenderId());
+        receivers[i] = touchPending(transactions[i].getReceiverId());
+        touchedAfter[i] = touchedSlots.size();
+    }
+
+    auto execute = [&](size_t i) {
+        Amount amount = AccountStore::toAmount(transactions[i].getAmount());
+        if (pendingBalances[senders[i]] < amount) {
+            return false;
+        }
+        pendingBalances[senders[i]] -= amount;
+        pendingBalances[receivers[i]] += amount;
+        pendingNonces[senders[i]] = std::max(pendingNonces[senders[i]], transactions[i].getNonce() + 1);
+        return true;
+    };
+
+    std::atomic<size_t> failedAt(count);
+    ThreadPool::shared().parallelFor(count, PARALLEL_EXECUTION_THRESHOLD / 4, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!conflicts[i] && !execute(i)) {
+                size_t earliest = failedAt.load();
+                while (i < earliest && !failedAt.compare_exchange_weak(earliest, i)) {
+                }
+            }
+        }
+    });
+
+    size_t failed = failedAt.load();
+    for (size_t i = 0; i < failed; ++i) {
+        if (conflicts[i] && !execute(i)) {
+            failed = i;
+            break;
+        }
+    }
+    if (failed == count) {
+        return true;
+    }
+
+    // Anything after the failing transaction must not take effect. A conflict-free transaction
+    // only touches accounts nothing before it touched, so dropping those slots from the overlay undoes it.
+    while (touchedSlots.size() > touchedAfter[failed]) {
+        pendingTouched[touchedSlots.back()] = 0;
+        touchedSlots.pop_back();
+    }
+    LOG_WARN("Transaction preparation failed: insufficient balance for sender " + std::to_string(transactions[failed].getSenderId()));
+    return false;
+}
+
 void StateMachine::commitState() {
+    std::lock_guard<std::mutex> lock(stateMutex);
     try {
-        balances = pendingBalances;
-        pendingBalances.clear();
+        for (uint32_t slot : touchedSlots) {
+            writeAccount(slot, pendingBalances[slot], pendingNonces[slot]);
+        }
+        clearPending();
+        hasPendingState = false;
     } catch (const std::exception& e) {
-        Utils::log("Error during state commit: " + std::string(e.what()));
+        LOG_ERROR("Error during state commit: " + std::string(e.what()));
     }
 }
 
 bool StateMachine::isCommitSuccessful() const {
-    return pendingBalances.empty(); // Example logic
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return !hasPendingState; // Example logic
 }
 
 
 void StateMachine::rollbackState() {
+    std::lock_guard<std::mutex> lock(stateMutex);
     if (!snapshots.empty()) {
-        balances = snapshots.back(); // Restore the last snapshot
+        // Undo writes newest first until the journal is back where the last snapshot left it
+        size_t mark = snapshots.back();
         snapshots.pop_back();
-        Utils::log("State rollback completed.");
+        while (journal.size() > mark) {
+            const JournalEntry& entry = journal.back();
+            if (entry.existed) {
+                setAccount(entry.slot, entry.balance, entry.nonce);
+            } else {
+                removeAccount(entry.slot);
+            }
+            journal.pop_back();
+        }
+        LOG_INFO("State rollback completed.");
     } else {
-        Utils::log("No snapshots available to rollback.");
+        LOG_WARN("No snapshots available to rollback.");
     }
 }
 
 double StateMachine::getBalance(int nodeId) const {
-    auto it = balances.find(nodeId);
-    if (it != balances.end()) {
-        return it->second;
+    std::lock_guard<std::mutex> lock(stateMutex);
+    uint32_t slot = accounts.findSlot(nodeId);
+    if (slot != AccountStore::NO_SLOT) {
+        return AccountStore::toDouble(accounts.getBalance(slot));
     }
     return 0.0; // Default to 0 if the node ID is not found
 }
 
+uint64_t StateMachine::getNonce(int nodeId) const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    uint32_t slot = accounts.findSlot(nodeId);
+    return slot != AccountStore::NO_SLOT ? accounts.getNonce(slot) : 0;
+}
+
 void StateMachine::createSnapshot() {
-    snapshots.push_back(balances); // Save the current state as a snapshot
-    Utils::log("State snapshot created.");
+    std::lock_guard<std::mutex> lock(stateMutex);
+    snapshots.push_back(journal.size()); // Later writes are journaled, so a snapshot is just a mark
+    LOG_DEBUG("State snapshot created.");
+}
+
+void StateMachine::releaseSnapshots() {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    snapshots.clear();
+    journal.clear();
+}
+
+size_t StateMachine::getSnapshotCount() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return snapshots.size();
+}
+
+Hash256 StateMachine::getStateRoot() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    std::string sum;
+    ByteWriter writer(sum);
+    for (uint64_t limb : rootSum) {
+        writer.writeU64(limb);
+    }
+    return Sha256::digest(sum.data(), sum.size());
+}
+
+void StateMachine::encodeSnapshot(std::string& out, uint64_t height) const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    std::string accountBytes;
+    encodeAccounts(accountBytes);
+    Hash256 checksum = Sha256::digest(accountBytes.data(), accountBytes.size());
+
+    ByteWriter writer(out);
+    writer.writeU32(SNAPSHOT_MAGIC);
+    writer.writeU32(SNAPSHOT_VERSION);
+    writer.writeU64(height);
+    writer.writeU64(accountBytes.size() / SNAPSHOT_ACCOUNT_SIZE);
+    writer.writeBytes(checksum.data(), Hash256::SIZE);
+    writer.writeBytes(accountBytes.data(), accountBytes.size());
+}
+
+uint64_t StateMachine::readSnapshotHeight(std::string_view bytes) {
+    ByteReader reader(bytes);
+    if (reader.readU32() != SNAPSHOT_MAGIC || reader.readU32() != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Not a state snapshot.");
+    }
+    return reader.readU64();
+}
+
+uint64_t StateMachine::restoreSnapshot(std::string_view bytes) {
+    ByteReader reader(bytes);
+    if (reader.readU32() != SNAPSHOT_MAGIC || reader.readU32() != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Not a state snapshot.");
+    }
+    uint64_t height = reader.readU64();
+    uint64_t accountCount = reader.readU64();
+    Hash256 checksum = Hash256::fromBytes(reader.readBytes(Hash256::SIZE).data());
+    if (bytes.size() - SNAPSHOT_HEADER_SIZE != accountCount * SNAPSHOT_ACCOUNT_SIZE) {
+        throw std::runtime_error("State snapshot has the wrong size.");
+    }
+    std::string_view accountBytes = bytes.substr(SNAPSHOT_HEADER_SIZE);
+    if (Sha256::digest(accountBytes.data(), accountBytes.size()) != checksum) {
+        throw std::runtime_error("State snapshot does not match its checksum.");
+    }
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    accounts.clear();
+    rootSum = {};
+    pendingBalances.clear();
+    pendingNonces.clear();
+    pendingTouched.clear();
+    touchedSlots.clear();
+    hasPendingState = false;
+    journal.clear();
+    snapshots.clear();
+
+    ByteReader accountReader(accountBytes);
+    for (uint64_t i = 0; i < accountCount; ++i) {
+        int nodeId = accountReader.readI32();
+        Amount balance = accountReader.readI64();
+        uint64_t nonce = accountReader.readU64();
+        setAccount(accounts.slotFor(nodeId), balance, nonce);
+    }
+    return height;
+}
+
+void StateMachine::encodeAccounts(std::string& out) const {
+    std::vector<uint32_t> slots;
+    for (uint32_t slot = 0; slot < accounts.slotCount(); ++slot) {
+        if (accounts.exists(slot)) {
+            slots.push_back(slot);
+        }
+    }
+    std::sort(slots.begin(), slots.end(), [this](uint32_t a, uint32_t b) { return accounts.getId(a) < accounts.getId(b); });
+
+    out.reserve(out.size() + slots.size() * SNAPSHOT_ACCOUNT_SIZE);
+    ByteWriter writer(out);
+    for (uint32_t slot : slots) {
+        writer.writeI32(accounts.getId(slot));
+        writer.writeI64(accounts.getBalance(slot));
+        writer.writeU64(accounts.getNonce(slot));
+    }
+}
+
+uint32_t StateMachine::touchPending(int nodeId) {
+    uint32_t slot = accounts.slotFor(nodeId);
+    if (slot >= pendingTouched.size()) {
+        size_t grown = std::max<size_t>(accounts.slotCount(), pendingTouched.size() * 2);
+        pendingBalances.resize(grown);
+        pendingNonces.resize(grown);
+        pendingTouched.resize(grown, 0);
+    }
+    if (!pendingTouched[slot]) {
+        pendingTouched[slot] = 1;
+        pendingBalances[slot] = accounts.getBalance(slot);
+        pendingNonces[slot] = accounts.getNonce(slot);
+        touchedSlots.push_back(slot);
+    }
+    return slot;
+}
+
+void StateMachine::clearPending() {
+    for (uint32_t slot : touchedSlots) {
+        pendingTouched[slot] = 0;
+    }
+    touchedSlots.clear();
+}
+
+void StateMachine::writeAccount(uint32_t slot, Amount balance, uint64_t nonce) {
+    if (!snapshots.empty()) {
+        journal.push_back({slot, accounts.getBalance(slot), accounts.getNonce(slot), accounts.exists(slot)});
+    }
+    setAccount(slot, balance, nonce);
+}
+
+void StateMachine::setAccount(uint32_t slot, Amount balance, uint64_t nonce) {
+    if (accounts.exists(slot)) {
+        addToRoot(slot, true);
+    }
+    accounts.setAccount(slot, balance, nonce);
+    addToRoot(slot, false);
+}
+
+void StateMachine::removeAccount(uint32_t slot) {
+    if (accounts.exists(slot)) {
+        addToRoot(slot, true);
+    }
+    accounts.removeAccount(slot);
+}
+
+void StateMachine::addToRoot(uint32_t slot, bool remove) {
+    // An account hashes the way the snapshot encodes it, so the slot it sits in does not matter
+    std::string encoded;
+    ByteWriter writer(encoded);
+    writer.writeI32(accounts.getId(slot));
+    writer.writeI64(accounts.getBalance(slot));
+    writer.writeU64(accounts.getNonce(slot));
+    Hash256 digest = Sha256::digest(encoded.data(), encoded.size());
+
+    ByteReader reader(std::string_view(reinterpret_cast<const char*>(digest.data()), Hash256::SIZE));
+    uint64_t carry = 0; // Or borrow, when removing
+    for (uint64_t& limb : rootSum) {
+        uint64_t term = reader.readU64();
+        uint64_t before = limb;
+        if (remove) {
+            limb = before - term - carry;
+            carry = (before < term || (before == term && carry)) ? 1 : 0;
+        } else {
+            limb = before + term + carry;
+            carry = (limb < before || (limb == before && carry)) ? 1 : 0;
+        }
+    }
 }
 
 void StateMachine::printState() const {
-    Utils::log("Current State:");
-    for (const auto& [nodeId, balance] : balances) {
-        std::cout << "  Node " << nodeId << ": Balance = " << balance << "\n";
+    if (!Logger::isEnabled(LogLevel::DEBUG)) {
+        return; // Walks every account, so skip it unless someone reads the output
+    }
+    std::lock_guard<std::mutex> lock(stateMutex);
+    std::string state = "Current State:";
+    size_t accountCount = 0;
+    for (uint32_t slot = 0; slot < accounts.slotCount(); ++slot) {
+        if (accounts.exists(slot)) {
+            state += "\n  Node " + std::to_string(accounts.getId(slot)) + ": Balance = " + std::to_string(AccountStore::toDouble(accounts.getBalance(slot)));
+            ++accountCount;
+        }
     }
 
     // Check for newly added nodes without explicit balances
-    for (int nodeId = 1; nodeId <= balances.size(); ++nodeId) {
-        if (balances.find(nodeId) == balances.end()) {
-            std::cout << "  Node " << nodeId << ": Balance = 0\n";
+    for (int nodeId = 1; nodeId <= static_cast<int>(accountCount); ++nodeId) {
+        uint32_t slot = accounts.findSlot(nodeId);
+        if (slot == AccountStore::NO_SLOT || !accounts.exists(slot)) {
+            state += "\n  Node " + std::to_string(nodeId) + ": Balance = 0";
         }
     }
+    LOG_DEBUG(state);
 }
 
 bool StateMachine::canProcessTransaction(const Transaction& tx) const {
-    auto it = balances.find(tx.getSenderId());
-    if (it != balances.end() && it->second >= tx.getAmount()) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    uint32_t slot = accounts.findSlot(tx.getSenderId());
+    if (slot != AccountStore::NO_SLOT && accounts.getBalance(slot) >= AccountStore::toAmount(tx.getAmount())) {
         return true; // Sufficient balance
     }
     return false; // Insufficient balance
-}
\ No newline at end of file
+}
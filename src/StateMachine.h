@@ -2,8 +2,13 @@
 #define STATEMACHINE_H
 
 #include "Transaction.h"
-#include <unordered_map>
+#include "AccountStore.h"
+#include "Hash256.h"
+#include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <mutex>
 
 class StateMachine {
 public:
@@ -14,16 +19,63 @@ public:
     void commitState();                                                   // 提交准备的状态
     void rollbackState();                                                 // 回滚到上一个状态
     double getBalance(int nodeId) const;                                  // 获取节点余额
+    uint64_t getNonce(int nodeId) const;                                  // Next nonce after the account's last applied transaction
     void createSnapshot();                                                // 创建快照
+    void releaseSnapshots();                                              // Drop snapshots once the state they guard is final
+    size_t getSnapshotCount() const;                                      // Snapshots not yet rolled back or released
     void printState() const;                                              // 打印当前状态
     bool StateMachine::canProcessTransaction(const Transaction& tx) const;
     bool isCommitSuccessful() const; // New method to check commit success
 
+    // Commits to every committed account whatever order it was written in, so equal states give
+    // equal roots. Kept up to date on each account write, so reading it does not walk the accounts.
+    Hash256 getStateRoot() const;
+    // Binary snapshot of the committed accounts, sorted by id, tagged with the height it reflects
+    // and a SHA-256 checksum of the account section. Walks and sorts every account.
+    void encodeSnapshot(std::string& out, uint64_t height) const;
+    uint64_t restoreSnapshot(std::string_view bytes); // Replaces all state; throws std::runtime_error if malformed or the checksum does not match, leaving the state untouched
+    static uint64_t readSnapshotHeight(std::string_view bytes); // Throws std::runtime_error if not a snapshot
+
+    static const size_t PARALLEL_EXECUTION_THRESHOLD = 2048; // Smaller blocks are prepared on the calling thread
+
 private:
-    std::unordered_map<int, double> balances;        // 节点账户余额
-    std::unordered_map<int, double> pendingBalances; // 准备中的状态
-    std::vector<std::unordered_map<int, double>> snapshots; // 快照历史
-    
+    // Account as it was before a write
+    struct JournalEntry {
+        uint32_t slot;
+        Amount balance;
+        uint64_t nonce;
+        bool existed;
+    };
+
+    AccountStore accounts; // 节点账户余额
+
+    // 准备中的状态: values for the slots the prepared block touches, indexed like accounts
+    std::vector<Amount> pendingBalances;
+    std::vector<uint64_t> pendingNonces;
+    std::vector<uint8_t> pendingTouched;
+    std::vector<uint32_t> touchedSlots;
+    bool hasPendingState;
+
+    std::vector<JournalEntry> journal; // Undo log of writes to accounts made since the oldest snapshot
+    std::array<uint64_t, 4> rootSum{}; // Sum of the hashes of all existing accounts mod 2^256, low limb first
+    std::vector<size_t> snapshots;     // 快照历史, as journal lengths
+    mutable std::mutex stateMutex; // Node workers may share one state machine
+
+
+    static const uint32_t SNAPSHOT_MAGIC = 0x4E534D54; // "TMSN"
+    static const uint32_t SNAPSHOT_VERSION = 1;
+    static const size_t SNAPSHOT_HEADER_SIZE = 4 + 4 + 8 + 8 + Hash256::SIZE;
+    static const size_t SNAPSHOT_ACCOUNT_SIZE = 4 + 8 + 8;
+
+    void encodeAccounts(std::string& out) const;
+    uint32_t touchPending(int nodeId); // Slot of the account, with its current values copied into the overlay
+    void clearPending();
+    bool prepareParallel(const std::vector<Transaction>& transactions);
+    void writeAccount(uint32_t slot, Amount balance, uint64_t nonce);
+    // Every change to accounts goes through these two, so rootSum stays current
+    void setAccount(uint32_t slot, Amount balance, uint64_t nonce);
+    void removeAccount(uint32_t slot);
+    void addToRoot(uint32_t slot, bool remove); // Add or take away the account's hash
 };
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// Fixed set of worker threads for CPU-bound data-parallel work (hashing, execution, verification)
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Runs body over [0, count) in chunks of at least grain items and returns when all are done.
+    // The calling thread works through chunks too, so nesting inside a pool task cannot deadlock.
+    // The first exception thrown by body is rethrown here.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+    size_t getThreadCount() const;
+
+    static ThreadPool& shared(); // One worker per hardware thread, created on first use
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksCondition;
+    bool stopping;
+
+    void workerLoop();
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <utility>
+
+// Hashed timing wheel: a timer lands in slot (dueMs / tickMs) % slotCount, so scheduling and
+// cancelling are O(1) and expiring only visits the slots the clock moved across. Timers further
+// out than one revolution share slots with nearer ones and are skipped until their turn.
+// Not thread-safe; the owner serializes access.
+template <typename T>
+class TimerWheel {
+public:
+    explicit TimerWheel(long long tickMs = 10, size_t slotCount = 512)
+        : tickMs(std::max(tickMs, 1LL)), slots(std::max<size_t>(slotCount, 1)), cursorTick(0), nextId(1) {}
+
+    uint64_t schedule(long long dueMs, T item) { // Returns an id for cancel()
+        uint64_t id = nextId++;
+        slotFor(dueMs).push_back({dueMs, id, std::move(item)});
+        dueById.emplace(id, dueMs);
+        return id;
+    }
+
+    bool cancel(uint64_t id) { // False if the timer already fired or never existed
+        auto it = dueById.find(id);
+        if (it == dueById.end()) {
+            return false;
+        }
+        std::vector<Entry>& slot = slotFor(it->second);
+        slot.erase(std::find_if(slot.begin(), slot.end(), [id](const Entry& entry) { return entry.id == id; }));
+        dueById.erase(it);
+        return true;
+    }
+
+    bool empty() const {
+        return dueById.empty();
+    }
+
+    size_t size() const {
+        return dueById.size();
+    }
+
+    long long nextDueMs() const { // LLONG_MAX when empty
+        if (dueById.empty()) {
+            return LLONG_MAX;
+        }
+        // Walk one revolution from the cursor; the first slot holding a timer due in that
+        // revolution has the earliest one. Only timers further out need the full scan.
+        for (size_t step = 0; step < slots.size(); ++step) {
+            long long tick = cursorTick + static_cast<long long>(step);
+            long long earliest = LLONG_MAX;
+            for (const Entry& entry : slots[tick % slots.size()]) {
+                if (entry.dueMs / tickMs <= tick) {
+                    earliest = std::min(earliest, entry.dueMs);
+                }
+            }
+            if (earliest != LLONG_MAX) {
+                return earliest;
+            }
+        }
+        long long earliest = LLONG_MAX;
+        for (const auto& timer : dueById) {
+            earliest = std::min(earliest, timer.second);
+        }
+        return earliest;
+    }
+
+    // Moves every timer due at or before nowMs into expired, ordered by due time then scheduling order
+    void popDue(long long nowMs, std::vector<T>& expired) {
+        long long targetTick = nowMs / tickMs;
+        std::vector<Entry> due;
+        long long ticks = targetTick - cursorTick + 1;
+        size_t visit = ticks >= static_cast<long long>(slots.size()) ? slots.size() : static_cast<size_t>(std::max(ticks, 1LL));
+        for (size_t step = 0; step < visit; ++step) {
+            std::vector<Entry>& slot = slots[(cursorTick + static_cast<long long>(step)) % slots.size()];
+            auto firstDue = std::partition(slot.begin(), slot.end(), [nowMs](const Entry& entry) { return entry.dueMs > nowMs; });
+            for (auto it = firstDue; it != slot.end(); ++it) {
+                dueById.erase(it->id);
+                due.push_back(std::move(*it));
+            }
+            slot.erase(firstDue, slot.end());
+        }
+        cursorTick = std::max(cursorTick, targetTick);
+
+        std::sort(due.begin(), due.end(), [](const Entry& a, const Entry& b) {
+            return a.dueMs != b.dueMs ? a.dueMs < b.dueMs : a.id < b.id;
+        });
+        for (Entry& entry : due) {
+            expired.push_back(std::move(entry.item));
+        }
+    }
+
+private:
+    struct Entry {
+        long long dueMs;
+        uint64_t id;
+        T item;
+    };
+
+    long long tickMs;
+    std::vector<std::vector<Entry>> slots;
+    long long cursorTick; // Tick of the last expiry; nothing due before it is left
+    uint64_t nextId;
+    std::unordered_map<uint64_t, long long> dueById;
+
+    std::vector<Entry>& slotFor(long long dueMs) {
+        return slots[static_cast<size_t>(dueMs / tickMs) % slots.size()];
+    }
+};
+
+#endif
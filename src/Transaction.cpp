@@ -1,8 +1,10 @@
 #include "Transaction.h"
+#include "Sha256.h"
+#include "Serialization.h"
 #include <sstream>
 
-Transaction::Transaction(int senderId, int receiverId, double amount)
-    : senderId(senderId), receiverId(receiverId), amount(amount) {}
+Transaction::Transaction(int senderId, int receiverId, double amount, uint64_t nonce, double fee)
+    : senderId(senderId), receiverId(receiverId), amount(amount), nonce(nonce), fee(fee) {}
 
 int Transaction::getSenderId() const {
     return senderId;
@@ -16,8 +18,49 @@ double Transaction::getAmount() const {
     return amount;
 }
 
+uint64_t Transaction::getNonce() const {
+    return nonce;
+}
+
+double Transaction::getFee() const {
+    return fee;
+}
+
+Hash256 Transaction::getHash() const {
+    uint8_t encoded[ENCODED_SIZE];
+    encode(encoded);
+    return Sha256::digest(encoded, ENCODED_SIZE);
+}
+
+size_t Transaction::getSize() const {
+    return ENCODED_SIZE;
+}
+
 std::string Transaction::toString() const {
     std::ostringstream ss;
     ss << "Transaction from Node " << senderId << " to Node " << receiverId << " of amount " << amount;
     return ss.str();
 }
+
+void Transaction::encode(uint8_t* out) const {
+    storeU32(out, static_cast<uint32_t>(senderId));
+    storeU32(out + 4, static_cast<uint32_t>(receiverId));
+    storeF64(out + 8, amount);
+    storeU64(out + 16, nonce);
+    storeF64(out + 24, fee);
+}
+
+void Transaction::serialize(std::string& out) const {
+    uint8_t encoded[ENCODED_SIZE];
+    encode(encoded);
+    out.append(reinterpret_cast<const char*>(encoded), ENCODED_SIZE);
+}
+
+Transaction Transaction::deserialize(ByteReader& reader) {
+    int senderId = reader.readI32();
+    int receiverId = reader.readI32();
+    double amount = reader.readF64();
+    uint64_t nonce = reader.readU64();
+    double fee = reader.readF64();
+    return Transaction(senderId, receiverId, amount, nonce, fee);
+}
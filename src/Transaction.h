@@ -1,23 +1,40 @@
 #ifndef TRANSACTION_H
 #define TRANSACTION_H
 
+#include "Hash256.h"
 #include <string>
 #include <sstream>
+#include <cstdint>
+
+class ByteReader;
 
 class Transaction {
 public:
-    Transaction(int senderId, int receiverId, double amount);
+    Transaction(int senderId, int receiverId, double amount, uint64_t nonce = 0, double fee = 0.0);
 
     int getSenderId() const;
     int getReceiverId() const;
     double getAmount() const;
+    uint64_t getNonce() const; // Per-sender sequence number, makes repeated transfers distinct
+    double getFee() const;     // Used by fee-ordered mempools
+
+    Hash256 getHash() const;     // Identity used for deduplication
+    size_t getSize() const;      // Encoded size in bytes, counted against the block size limit
 
     std::string toString() const;
 
+    void encode(uint8_t* out) const;        // Write the ENCODED_SIZE-byte canonical encoding
+    void serialize(std::string& out) const; // Append the canonical encoding
+    static Transaction deserialize(ByteReader& reader);
+
+    static const size_t ENCODED_SIZE = 4 + 4 + 8 + 8 + 8; // sender, receiver, amount, nonce, fee
+
 private:
     int senderId;
     int receiverId;
     double amount;
+    uint64_t nonce;
+    double fee;
 };
 
 #endif
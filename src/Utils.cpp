@@ -1,20 +1,46 @@
 #include "Utils.h"
-#include <iostream>
+#include "Logger.h"
 #include <openssl/sha.h>
-#include <sstream>
 
-std::string Utils::calculateHash(const std::string& input) {
-    unsigned char hashBytes[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)input.c_str(), input.size(), hashBytes);
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
-    std::stringstream hashString;
-    for (unsigned char byte : hashBytes) {
-        hashString << std::hex << (int)byte;
-    }
-
-    return hashString.str();
+Hash256 Utils::calculateHash(std::string_view input) {
+    Hash256 hash;
+    SHA256(reinterpret_cast<const unsigned char*>(input.data()), input.size(), hash.data());
+    return hash;
 }
 
 void Utils::log(const std::string& message) {
-    std::cout << "[LOG] " << message << std::endl;
+    LOG_INFO(message);
+}
+
+bool Utils::syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool Utils::syncDirectory(const std::string& path) {
+#ifdef _WIN32
+    (void)path; // Directories cannot be opened for fsync here; NTFS journals its metadata
+    return true;
+#else
+    int descriptor = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+    if (descriptor < 0) {
+        return false;
+    }
+    bool synced = fsync(descriptor) == 0;
+    close(descriptor);
+    return synced;
+#endif
 }
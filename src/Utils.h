@@ -3,12 +3,17 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "Hash256.h"
 #include <string>
+#include <string_view>
+#include <cstdio>
 
 class Utils {
 public:
-    static std::string calculateHash(const std::string& input);
-    static void log(const std::string& message);
+    static Hash256 calculateHash(std::string_view input); // SHA-256 of the input
+    static void log(const std::string& message); // LOG_INFO, but the message is built even when INFO is off
+    static bool syncFile(std::FILE* file); // Flush stdio buffers and force the data to disk; false if either failed
+    static bool syncDirectory(const std::string& path); // Make renames and deletions in it durable; false on failure
 };
 
 #endif
@@ -0,0 +1,163 @@
+#include "ValidatorSet.h"
+#include <algorithm>
+#include <stdexcept>
+
+ValidatorSet::ValidatorSet() : totalPower(0), proposerIndex(NO_INDEX) {}
+
+void ValidatorSet::update(int id, uint64_t votingPower) {
+    update({{id, votingPower}});
+}
+
+void ValidatorSet::update(const std::vector<std::pair<int, uint64_t>>& changes) {
+    // Check the resulting total first so a rejected batch leaves the set untouched
+    std::unordered_map<int, uint64_t> finalPower;
+    for (const auto& change : changes) {
+        finalPower[change.first] = change.second;
+    }
+    uint64_t newTotal = totalPower;
+    for (const auto& change : finalPower) {
+        auto found = indexById.find(change.first);
+        newTotal -= found == indexById.end() ? 0 : validators[found->second].votingPower;
+        if (change.second > MAX_TOTAL_VOTING_POWER || newTotal + change.second > MAX_TOTAL_VOTING_POWER) {
+            throw std::invalid_argument("Total voting power would exceed the supported maximum.");
+        }
+        newTotal += change.second;
+    }
+    if (finalPower.empty()) {
+        return;
+    }
+    totalPower = newTotal;
+    proposerIndex = NO_INDEX;
+
+    int64_t total = static_cast<int64_t>(totalPower);
+    int64_t joiningPriority = -(total + (total >> 3));
+    for (const auto& change : changes) {
+        auto found = indexById.find(change.first);
+        if (finalPower[change.first] != change.second) {
+            continue; // A later change in the batch overrides this one
+        }
+        if (found == indexById.end()) {
+            if (change.second != 0) {
+                indexById.emplace(change.first, validators.size());
+                validators.push_back({change.first, change.second, joiningPriority});
+            }
+        } else if (change.second == 0) {
+            // Swap with the last validator so leaving costs O(1); only that one changes index
+            size_t index = found->second;
+            indexById.erase(found);
+            if (index != validators.size() - 1) {
+                validators[index] = validators.back();
+                indexById[validators[index].id] = index;
+            }
+            validators.pop_back();
+        } else {
+            validators[found->second].votingPower = change.second;
+        }
+    }
+
+    rescalePriorities();
+    shiftByAveragePriority();
+}
+
+void ValidatorSet::incrementProposerPriority(uint32_t times) {
+    if (validators.empty()) {
+        return;
+    }
+    rescalePriorities();
+    shiftByAveragePriority();
+
+    int64_t total = static_cast<int64_t>(totalPower);
+    for (uint32_t step = 0; step < times; ++step) {
+        size_t mostest = 0;
+        for (size_t i = 0; i < validators.size(); ++i) {
+            Validator& validator = validators[i];
+            validator.proposerPriority += static_cast<int64_t>(validator.votingPower);
+            const Validator& best = validators[mostest];
+            // Equal priorities go to the lower id, so the order validators joined in does not matter
+            if (validator.proposerPriority > best.proposerPriority ||
+                (validator.proposerPriority == best.proposerPriority && validator.id < best.id)) {
+                mostest = i;
+            }
+        }
+        validators[mostest].proposerPriority -= total;
+        proposerIndex = mostest;
+    }
+}
+
+void ValidatorSet::rescalePriorities() {
+    if (validators.empty()) {
+        return;
+    }
+    auto bounds = std::minmax_element(validators.begin(), validators.end(), [](const Validator& a, const Validator& b) {
+        return a.proposerPriority < b.proposerPriority;
+    });
+    int64_t diff = bounds.second->proposerPriority - bounds.first->proposerPriority;
+    int64_t diffMax = PRIORITY_WINDOW_FACTOR * static_cast<int64_t>(totalPower);
+    if (diffMax > 0 && diff > diffMax) {
+        int64_t ratio = (diff + diffMax - 1) / diffMax;
+        for (Validator& validator : validators) {
+            validator.proposerPriority /= ratio;
+        }
+    }
+}
+
+void ValidatorSet::shiftByAveragePriority() {
+    if (validators.empty()) {
+        return;
+    }
+    // Floor of the mean, summed as quotients and remainders so a large set cannot overflow the sum
+    int64_t count = static_cast<int64_t>(validators.size());
+    int64_t quotients = 0;
+    int64_t remainders = 0;
+    for (const Validator& validator : validators) {
+        int64_t quotient = validator.proposerPriority / count;
+        int64_t remainder = validator.proposerPriority % count;
+        if (remainder < 0) {
+            quotient--;
+            remainder += count;
+        }
+        quotients += quotient;
+        remainders += remainder;
+    }
+    int64_t average = quotients + remainders / count;
+    for (Validator& validator : validators) {
+        validator.proposerPriority -= average;
+    }
+}
+
+size_t ValidatorSet::size() const {
+    return validators.size();
+}
+
+bool ValidatorSet::empty() const {
+    return validators.empty();
+}
+
+bool ValidatorSet::contains(int id) const {
+    return indexById.count(id) != 0;
+}
+
+size_t ValidatorSet::getIndex(int id) const {
+    auto found = indexById.find(id);
+    return found == indexById.end() ? NO_INDEX : found->second;
+}
+
+const Validator& ValidatorSet::getValidator(size_t index) const {
+    return validators.at(index);
+}
+
+const std::vector<Validator>& ValidatorSet::getValidators() const {
+    return validators;
+}
+
+uint64_t ValidatorSet::getTotalPower() const {
+    return totalPower;
+}
+
+uint64_t ValidatorSet::getQuorumPower() const {
+    return totalPower * 2 / 3 + 1;
+}
+
+const Validator* ValidatorSet::getProposer() const {
+    return proposerIndex == NO_INDEX ? nullptr : &validators[proposerIndex];
+}
@@ -0,0 +1,55 @@
+#ifndef VALIDATOR_SET_H
+#define VALIDATOR_SET_H
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+struct Validator {
+    int id;                    // Node id
+    uint64_t votingPower;
+    int64_t proposerPriority;  // Grows by votingPower every step, the highest proposes and pays the total back
+};
+
+// Validators with voting power and Tendermint's proposer-priority rotation: over any stretch of
+// heights each validator proposes in proportion to its power. Index order is join order and is
+// the bit position in vote sets, so every node must apply the same updates in the same order.
+class ValidatorSet {
+public:
+    ValidatorSet();
+
+    // Adds validators, changes their power, or removes them when the power is 0. Validators added
+    // in one batch start level with each other and behind everyone else, so joining is no shortcut
+    // to proposing. Throws std::invalid_argument, changing nothing, if the total power would leave
+    // no headroom for priorities.
+    void update(const std::vector<std::pair<int, uint64_t>>& changes);
+    void update(int id, uint64_t votingPower);
+    void incrementProposerPriority(uint32_t times); // Advance the rotation, e.g. once per height or round
+
+    size_t size() const;
+    bool empty() const;
+    bool contains(int id) const;
+    size_t getIndex(int id) const; // NO_INDEX when id is not a validator
+    const Validator& getValidator(size_t index) const;
+    const std::vector<Validator>& getValidators() const;
+    uint64_t getTotalPower() const;
+    uint64_t getQuorumPower() const;     // More than two thirds of the total power
+    const Validator* getProposer() const; // Null until the rotation has advanced since the last update
+
+    static constexpr size_t NO_INDEX = static_cast<size_t>(-1);
+    static constexpr uint64_t MAX_TOTAL_VOTING_POWER = INT64_MAX / 8;
+    static constexpr int64_t PRIORITY_WINDOW_FACTOR = 2; // Priorities stay within this many total powers of each other
+
+private:
+    std::vector<Validator> validators;
+    std::unordered_map<int, size_t> indexById;
+    uint64_t totalPower;
+    size_t proposerIndex;
+
+    void rescalePriorities();
+    void shiftByAveragePriority(); // Keeps priorities centred on zero so they cannot drift into overflow
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "VoteSet.h"
+#include <algorithm>
+
+BitArray::BitArray(size_t size) : bits(0), setCount(0) {
+    reset(size);
+}
+
+void BitArray::reset(size_t size) {
+    bits = size;
+    setCount = 0;
+    words.assign((size + 63) / 64, 0);
+}
+
+bool BitArray::get(size_t index) const {
+    if (index >= bits) {
+        return false;
+    }
+    return (words[index / 64] >> (index % 64)) & 1;
+}
+
+bool BitArray::set(size_t index) {
+    if (index >= bits) {
+        return false;
+    }
+    uint64_t mask = uint64_t(1) << (index % 64);
+    uint64_t& word = words[index / 64];
+    if (word & mask) {
+        return false;
+    }
+    word |= mask;
+    setCount++;
+    return true;
+}
+
+size_t BitArray::count() const {
+    return setCount;
+}
+
+size_t BitArray::size() const {
+    return bits;
+}
+
+VoteSet::VoteSet() : VoteSet(0, 0, PREVOTE, 0, 1) {}
+
+VoteSet::VoteSet(uint64_t height, uint32_t round, MessageType type, size_t validatorCount, uint64_t quorumPower)
+    : height(0), round(0), type(type), quorumPower(0), totalPower(0), majority(-1) {
+    reset(height, round, type, validatorCount, quorumPower);
+}
+
+void VoteSet::reset(uint64_t newHeight, uint32_t newRound, MessageType newType, size_t validatorCount, uint64_t newQuorumPower) {
+    height = newHeight;
+    round = newRound;
+    type = newType;
+    quorumPower = std::max<uint64_t>(newQuorumPower, 1); // A zero quorum would be met by nobody voting
+    voters.reset(validatorCount);
+    tallies.clear();
+    totalPower = 0;
+    majority = -1;
+}
+
+bool VoteSet::addVote(size_t validatorIndex, const Hash256& blockHash, uint64_t power) {
+    if (!voters.set(validatorIndex)) {
+        return false;
+    }
+    totalPower += power;
+
+    auto tally = std::find_if(tallies.begin(), tallies.end(), [&blockHash](const Tally& t) { return t.blockHash == blockHash; });
+    if (tally == tallies.end()) {
+        tallies.push_back({blockHash, 0});
+        tally = tallies.end() - 1;
+    }
+    tally->power += power;
+    if (majority < 0 && tally->power >= quorumPower) {
+        majority = static_cast<int>(tally - tallies.begin());
+    }
+    return true;
+}
+
+bool VoteSet::hasVoted(size_t validatorIndex) const {
+    return voters.get(validatorIndex);
+}
+
+const VoteSet::Tally* VoteSet::findTally(const Hash256& blockHash) const {
+    for (const Tally& tally : tallies) {
+        if (tally.blockHash == blockHash) {
+            return &tally;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t VoteSet::getPower(const Hash256& blockHash) const {
+    const Tally* tally = findTally(blockHash);
+    return tally ? tally->power : 0;
+}
+
+uint64_t VoteSet::getTotalPower() const {
+    return totalPower;
+}
+
+bool VoteSet::hasQuorum(const Hash256& blockHash) const {
+    return getPower(blockHash) >= quorumPower;
+}
+
+bool VoteSet::hasQuorumAny() const {
+    return totalPower >= quorumPower;
+}
+
+std::optional<Hash256> VoteSet::getMajority() const {
+    if (majority < 0) {
+        return std::nullopt;
+    }
+    return tallies[majority].blockHash;
+}
+
+const BitArray& VoteSet::getVoters() const {
+    return voters;
+}
+
+uint64_t VoteSet::getHeight() const {
+    return height;
+}
+
+uint32_t VoteSet::getRound() const {
+    return round;
+}
+
+MessageType VoteSet::getType() const {
+    return type;
+}
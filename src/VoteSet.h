@@ -0,0 +1,69 @@
+#ifndef VOTE_SET_H
+#define VOTE_SET_H
+
+#include "Hash256.h"
+#include "Message.h"
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+// Fixed-size set of validator indices, one bit each
+class BitArray {
+public:
+    explicit BitArray(size_t size = 0);
+
+    void reset(size_t size); // Resize and clear, keeping the allocation where possible
+    bool get(size_t index) const; // False past the end
+    bool set(size_t index);       // False if already set or past the end
+    size_t count() const;         // Bits set, kept up to date by set()
+    size_t size() const;
+
+private:
+    std::vector<uint64_t> words;
+    size_t bits;
+    size_t setCount;
+};
+
+// Votes of one type for one (height, round). Each validator's first vote counts; the
+// voting power behind every block hash is summed as votes arrive, so quorum checks are
+// O(1) against the running totals. A zero block hash is a nil vote.
+class VoteSet {
+public:
+    VoteSet();
+    VoteSet(uint64_t height, uint32_t round, MessageType type, size_t validatorCount, uint64_t quorumPower);
+
+    void reset(uint64_t height, uint32_t round, MessageType type, size_t validatorCount, uint64_t quorumPower);
+    bool addVote(size_t validatorIndex, const Hash256& blockHash, uint64_t power = 1); // False for a second vote or an unknown index
+
+    bool hasVoted(size_t validatorIndex) const;
+    uint64_t getPower(const Hash256& blockHash) const; // Power that voted for blockHash
+    uint64_t getTotalPower() const;                    // Power that voted for anything
+    bool hasQuorum(const Hash256& blockHash) const;
+    bool hasQuorumAny() const;                   // Enough votes in, whatever they are for
+    std::optional<Hash256> getMajority() const;  // The hash with a quorum, if one has it
+    const BitArray& getVoters() const;
+
+    uint64_t getHeight() const;
+    uint32_t getRound() const;
+    MessageType getType() const;
+
+private:
+    struct Tally {
+        Hash256 blockHash;
+        uint64_t power;
+    };
+
+    uint64_t height;
+    uint32_t round;
+    MessageType type;
+    uint64_t quorumPower;
+    BitArray voters;
+    std::vector<Tally> tallies; // One per distinct hash; usually the proposal and nil, so a scan beats hashing
+    uint64_t totalPower;
+    int majority;               // Index into tallies of the hash with a quorum, -1 until one has it
+
+    const Tally* findTally(const Hash256& blockHash) const;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "WriteAheadLog.h"
+#include "Serialization.h"
+#include "Sha256.h"
+#include "Utils.h"
+#include "Logger.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+WriteAheadLog::WriteAheadLog(const std::string& path, FsyncPolicy fsyncPolicy)
+    : path(path), fsyncPolicy(fsyncPolicy), file(nullptr), syncCount(0) {
+    size_t validBytes = 0;
+    if (fs::exists(path)) {
+        std::ifstream input(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        ByteReader reader(bytes);
+        try {
+            while (!reader.atEnd()) {
+                uint32_t length = reader.readU32();
+                uint32_t expected = reader.readU32();
+                WalEntryType type = static_cast<WalEntryType>(reader.readU8());
+                std::string_view data = reader.readBytes(length);
+                if (checksum(type, data) != expected) {
+                    break;
+                }
+                recoveredEntries.push_back({type, std::string(data)});
+                validBytes = reader.getPosition();
+            }
+        } catch (const std::runtime_error&) {
+            // Truncated record: the process died while writing it
+        }
+        if (validBytes != bytes.size()) {
+            LOG_WARN("Discarding " + std::to_string(bytes.size() - validBytes) + " torn bytes at the end of " + path);
+            fs::resize_file(path, validBytes);
+        }
+    } else if (fs::path(path).has_parent_path()) {
+        fs::create_directories(fs::path(path).parent_path());
+    }
+
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path + " for appending.");
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    try {
+        sync();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Write-ahead log not synced on close: " + std::string(e.what()));
+    }
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+const std::vector<WalEntry>& WriteAheadLog::getRecoveredEntries() const {
+    return recoveredEntries;
+}
+
+void WriteAheadLog::append(WalEntryType type, std::string_view data) {
+    ByteWriter writer(buffer);
+    writer.writeU32(static_cast<uint32_t>(data.size()));
+    writer.writeU32(checksum(type, data));
+    writer.writeU8(static_cast<uint8_t>(type));
+    writer.writeBytes(data.data(), data.size());
+}
+
+void WriteAheadLog::sync() {
+    if (buffer.empty()) {
+        return;
+    }
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size() || std::fflush(file) != 0) {
+        throw std::runtime_error("Cannot write to " + path);
+    }
+    if (fsyncPolicy != FsyncPolicy::NEVER && !Utils::syncFile(file)) {
+        throw std::runtime_error("Cannot sync " + path);
+    }
+    buffer.clear();
+    ++syncCount;
+}
+
+void WriteAheadLog::reset() {
+    buffer.clear();
+    std::fclose(file);
+    file = std::fopen(path.c_str(), "wb"); // Truncates
+    if (!file) {
+        throw std::runtime_error("Cannot reopen " + path);
+    }
+    // Otherwise a crash can bring back records of a height already committed
+    if (fsyncPolicy != FsyncPolicy::NEVER && !Utils::syncFile(file)) {
+        throw std::runtime_error("Cannot sync " + path);
+    }
+}
+
+bool WriteAheadLog::hasBufferedEntries() const {
+    return !buffer.empty();
+}
+
+size_t WriteAheadLog::getSyncCount() const {
+    return syncCount;
+}
+
+uint32_t WriteAheadLog::checksum(WalEntryType type, std::string_view data) {
+    Sha256 hasher;
+    uint8_t typeByte = static_cast<uint8_t>(type);
+    hasher.update(&typeByte, 1);
+    hasher.update(data.data(), data.size());
+    Hash256 digest = hasher.finish();
+    return ByteReader(std::string_view(reinterpret_cast<const char*>(digest.data()), 4)).readU32();
+}
@@ -0,0 +1,55 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include "Config.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+// What a consensus WAL record holds
+enum class WalEntryType : uint8_t {
+    PROPOSAL = 1, // Encoded proposal message, block included, that we proposed or accepted
+    VOTE = 2,     // Encoded prevote or precommit we sent
+    COMMIT = 3    // Height and block hash we decided, written before the block is stored
+};
+
+struct WalEntry {
+    WalEntryType type;
+    std::string data;
+};
+
+// Append-only record log: length | checksum | type | data per record. Appends are buffered and
+// sync() writes everything buffered with a single fsync, so all records produced while handling
+// one message share one disk flush (group commit). Once a height is safely committed, reset()
+// empties the log, which keeps it as short as the uncommitted tail.
+class WriteAheadLog {
+public:
+    explicit WriteAheadLog(const std::string& path, FsyncPolicy fsyncPolicy = Config::getFsyncPolicy()); // Throws std::runtime_error
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    const std::vector<WalEntry>& getRecoveredEntries() const; // Records found on open, torn tail dropped
+
+    void append(WalEntryType type, std::string_view data);
+    void sync();  // No-op when nothing is buffered
+    void reset(); // Drop every record, buffered or on disk
+
+    bool hasBufferedEntries() const;
+    size_t getSyncCount() const; // Disk flushes so far
+
+private:
+    std::string path;
+    FsyncPolicy fsyncPolicy;
+    std::FILE* file;
+    std::string buffer;
+    std::vector<WalEntry> recoveredEntries;
+    size_t syncCount;
+
+    static uint32_t checksum(WalEntryType type, std::string_view data);
+};
+
+#endif
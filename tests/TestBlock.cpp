@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include "Block.h"
+#include "Sha256.h"
+
+TEST(BlockTest, BlockHashCommitsToTransactions) {
+    Block empty(1, Hash256(), {});
+    EXPECT_TRUE(empty.getMerkleRoot().isZero());
+
+    Block block(1, Hash256(), {Transaction(1, 2, 10.0, 0), Transaction(2, 3, 5.0, 0)});
+    Block same(1, Hash256(), {Transaction(1, 2, 10.0, 0), Transaction(2, 3, 5.0, 0)});
+    Block changed(1, Hash256(), {Transaction(1, 2, 10.0, 0), Transaction(2, 3, 5.0, 1)});
+
+    EXPECT_EQ(block.getHash(), same.getHash());
+    EXPECT_NE(block.getMerkleRoot(), changed.getMerkleRoot());
+    EXPECT_NE(block.getHash(), changed.getHash());
+    EXPECT_NE(block.getHash(), empty.getHash());
+}
+
+TEST(BlockTest, BlockSingleTransactionRootIsLeafHash) {
+    Transaction tx(1, 2, 10.0, 3);
+    uint8_t leaf[1 + Transaction::ENCODED_SIZE];
+    leaf[0] = 0x00;
+    tx.encode(leaf + 1);
+
+    Block block(1, Hash256(), {tx});
+    EXPECT_EQ(block.getMerkleRoot(), Sha256::digest(leaf, sizeof(leaf)));
+}
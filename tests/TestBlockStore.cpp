@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include "BlockStore.h"
+#include "Blockchain.h"
+#include "HashIndex.h"
+#include "Sha256.h"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static std::string freshDirectory(const std::string& name) {
+    fs::path directory = fs::temp_directory_path() / name;
+    fs::remove_all(directory);
+    return directory.string();
+}
+
+static std::vector<Block> makeChain(int length) {
+    std::vector<Block> blocks;
+    blocks.emplace_back(0, Hash256(), std::vector<Transaction>{});
+    for (int height = 1; height < length; ++height) {
+        blocks.emplace_back(height, blocks.back().getHash(),
+                            std::vector<Transaction>{Transaction(1, 2, height, height), Transaction(2, 3, 1.0, height)});
+    }
+    return blocks;
+}
+
+TEST(BlockStoreTest, ReopenReadsEveryBlockAcrossSegments) {
+    std::string directory = freshDirectory("tendermint-blockstore-reopen");
+    std::vector<Block> blocks = makeChain(100);
+    {
+        BlockStore store(directory, 512, FsyncPolicy::NEVER); // Small segments force many rollovers
+        for (const Block& block : blocks) {
+            store.append(block);
+        }
+        EXPECT_EQ(store.readBlock(42).getHash(), blocks[42].getHash());
+        EXPECT_THROW(store.append(blocks[5]), std::runtime_error);
+    }
+    EXPECT_TRUE(fs::exists(fs::path(directory) / "segment-00000010.log"));
+
+    BlockStore reopened(directory, 512, FsyncPolicy::NEVER);
+    ASSERT_EQ(reopened.getBlockCount(), blocks.size());
+    for (size_t height = 0; height < blocks.size(); ++height) {
+        EXPECT_EQ(reopened.readBlock(height).getHash(), blocks[height].getHash());
+    }
+    EXPECT_THROW(reopened.readBlock(blocks.size()), std::out_of_range);
+    fs::remove_all(directory);
+}
+
+TEST(BlockStoreTest, RecoveryDropsTornTailAndStaleIndex) {
+    std::string directory = freshDirectory("tendermint-blockstore-torn");
+    std::vector<Block> blocks = makeChain(10);
+    {
+        BlockStore store(directory, 1 << 20, FsyncPolicy::EVERY_BLOCK);
+        for (const Block& block : blocks) {
+            store.append(block);
+        }
+    }
+    {
+        // Half a record at the end, as if the process died mid-write
+        std::ofstream segment(fs::path(directory) / "segment-00000000.log", std::ios::binary | std::ios::app);
+        segment.write("\x40\x00\x00\x00partial", 11);
+    }
+    fs::resize_file(fs::path(directory) / "index.dat", 3 * 16 + 5);
+
+    BlockStore store(directory, 1 << 20, FsyncPolicy::EVERY_BLOCK);
+    ASSERT_EQ(store.getBlockCount(), blocks.size());
+    store.append(Block(10, blocks.back().getHash(), {}));
+    EXPECT_EQ(store.readBlock(10).getPreviousHash(), blocks.back().getHash());
+    EXPECT_EQ(store.readBlock(9).getHash(), blocks[9].getHash());
+    fs::remove_all(directory);
+}
+
+TEST(BlockStoreTest, BlockchainSurvivesRestart) {
+    std::string directory = freshDirectory("tendermint-blockchain-restart");
+    std::vector<Block> blocks = makeChain(5);
+    {
+        Blockchain blockchain;
+        ASSERT_TRUE(blockchain.open(directory));
+        for (size_t height = 1; height < blocks.size(); ++height) {
+            EXPECT_TRUE(blockchain.addBlock(blocks[height]));
+        }
+    }
+
+    Blockchain restarted;
+    ASSERT_TRUE(restarted.open(directory));
+    EXPECT_TRUE(restarted.isPersistent());
+    EXPECT_EQ(restarted.getChainLength(), 5);
+    EXPECT_EQ(restarted.getLatestBlock().getHash(), blocks[4].getHash());
+    EXPECT_EQ(restarted.getBlock(2)->getTransactions().size(), 2u);
+    EXPECT_EQ(restarted.getBlock(5), nullptr);
+    fs::remove_all(directory);
+}
+
+TEST(BlockStoreTest, BlockchainIndexesHashesAndTransactions) {
+    std::string directory = freshDirectory("tendermint-blockchain-index");
+    std::vector<Block> blocks = makeChain(Config::getBlockCacheSize() + 10);
+    {
+        Blockchain blockchain;
+        ASSERT_TRUE(blockchain.open(directory));
+        for (size_t height = 1; height < blocks.size(); ++height) {
+            ASSERT_TRUE(blockchain.addBlock(blocks[height]));
+        }
+    }
+
+    Blockchain blockchain;
+    ASSERT_TRUE(blockchain.open(directory));
+    for (int height : {3, 200, 3, 0, static_cast<int>(blocks.size()) - 1}) {
+        EXPECT_EQ(blockchain.getBlockByHash(blocks[height].getHash())->getIndex(), height);
+    }
+    EXPECT_EQ(blockchain.getBlockByHash(Hash256()), nullptr);
+
+    Transaction committed = blocks[150].getTransactions()[1];
+    std::optional<TransactionLocation> location = blockchain.findTransaction(committed.getHash());
+    ASSERT_TRUE(location.has_value());
+    EXPECT_EQ(location->height, 150);
+    EXPECT_EQ(location->position, 1u);
+    EXPECT_FALSE(blockchain.findTransaction(Transaction(9, 9, 9.0, 9).getHash()).has_value());
+
+    // Walk more blocks than the cache holds, twice, so reads keep evicting and reloading
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int height = 0; height < blockchain.getChainLength(); ++height) {
+            ASSERT_EQ(blockchain.getBlock(height)->getHash(), blocks[height].getHash());
+        }
+    }
+    fs::remove_all(directory);
+}
+
+TEST(BlockStoreTest, HashIndexKeepsLogarithmicRunsAcrossRestarts) {
+    std::string directory = freshDirectory("tendermint-hash-index");
+    auto hashOf = [](uint64_t height) { return Sha256::digest(&height, sizeof(height)); };
+    {
+        HashIndex index(directory, "test", 0, FsyncPolicy::NEVER);
+        for (int height = 0; height < 1000; ++height) {
+            index.add(hashOf(height), height, 7);
+            if (height == 900) {
+                index.add(hashOf(10), height); // A duplicate keeps its first location
+            }
+            index.endHeight(height);
+        }
+        EXPECT_LE(index.getRunCount(), 4u); // 15 flushes of 64 heights, merged like a binary counter
+        EXPECT_EQ(index.find(hashOf(10))->height, 10);
+    }
+
+    {
+        HashIndex reopened(directory, "test", 1000, FsyncPolicy::NEVER);
+        EXPECT_EQ(reopened.getIndexedHeights(), 1000u);
+        EXPECT_EQ(reopened.find(hashOf(3))->height, 3);
+        EXPECT_EQ(reopened.find(hashOf(3))->position, 7u);
+        EXPECT_EQ(reopened.find(hashOf(999))->height, 999);
+        EXPECT_EQ(reopened.find(hashOf(10))->height, 10);
+        EXPECT_FALSE(reopened.find(Hash256()).has_value());
+    }
+
+    // The block store lost its tail: runs reaching past it are dropped and indexed again by the caller
+    HashIndex truncated(directory, "test", 500, FsyncPolicy::NEVER);
+    EXPECT_LT(truncated.getIndexedHeights(), 500u);
+    EXPECT_FALSE(truncated.find(hashOf(999)).has_value());
+    fs::remove_all(directory);
+}
+
+TEST(BlockStoreTest, BlockCacheEvictsLeastRecentlyUsed) {
+    std::vector<Block> blocks = makeChain(4);
+    BlockCache cache(2);
+    cache.put(1, std::make_shared<const Block>(blocks[1]));
+    cache.put(2, std::make_shared<const Block>(blocks[2]));
+    EXPECT_NE(cache.get(1), nullptr); // 2 is now the oldest
+    cache.put(3, std::make_shared<const Block>(blocks[3]));
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.get(2), nullptr);
+    EXPECT_EQ(cache.get(1)->getHash(), blocks[1].getHash());
+    EXPECT_EQ(cache.get(3)->getHash(), blocks[3].getHash());
+}
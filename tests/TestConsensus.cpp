@@ -3,6 +3,11 @@
 #include "Node.h"
 #include "StateMachine.h"
 #include "Network.h"
+#include "Serialization.h"
+#include "Config.h"
+#include <memory>
+#include <vector>
+#include <filesystem>
 
 TEST(ConsensusTest, ConsensusProposal) {
     Network network;
@@ -27,3 +32,155 @@ TEST(ConsensusTest, ConsensusHandleMessages) {
     Message proposalMessage(PROPOSAL, 2, "Block_1");
     consensus.onReceiveMessage(proposalMessage);
 }
+
+TEST(ConsensusTest, ConsensusCommitsBlocksOnEveryNode) {
+    Network network;
+    std::vector<std::unique_ptr<StateMachine>> stateMachines;
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (int id = 1; id <= 4; ++id) {
+        stateMachines.push_back(std::make_unique<StateMachine>());
+        nodes.push_back(std::make_unique<Node>(id, &network, stateMachines.back().get()));
+        network.registerNode(nodes.back().get());
+    }
+
+    nodes[0]->createTransaction(2, 100.0);
+    nodes[2]->createTransaction(4, 50.0);
+    nodes[0]->proposeBlock(); // Node 1 leads height 1
+    network.run();
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i]->getBlockchain().getChainLength(), 2);
+        EXPECT_EQ(nodes[i]->getBlockchain().getLatestBlock().getTransactions().size(), 2u);
+        EXPECT_DOUBLE_EQ(stateMachines[i]->getBalance(1), 900.0);
+        EXPECT_DOUBLE_EQ(stateMachines[i]->getBalance(4), 1050.0);
+    }
+    EXPECT_TRUE(network.getMempool().empty());
+
+    // Height 2 is led by node 2 and chains onto the first block
+    nodes[1]->createTransaction(3, 10.0);
+    nodes[1]->proposeBlock();
+    network.run();
+    for (const auto& node : nodes) {
+        const Blockchain& chain = node->getBlockchain();
+        ASSERT_EQ(chain.getChainLength(), 3);
+        ASSERT_NE(chain.getBlock(1), nullptr);
+        EXPECT_EQ(chain.getLatestBlock().getPreviousHash(), chain.getBlock(1)->getHash());
+        EXPECT_EQ(chain.getLatestBlock().getHash(), nodes[0]->getBlockchain().getLatestBlock().getHash());
+    }
+}
+
+TEST(ConsensusTest, PipelinedExecutionDefersTheAppHash) {
+    Network network;
+    network.setPipelinedExecution(true);
+    std::vector<std::unique_ptr<StateMachine>> stateMachines;
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (int id = 1; id <= 4; ++id) {
+        stateMachines.push_back(std::make_unique<StateMachine>());
+        nodes.push_back(std::make_unique<Node>(id, &network, stateMachines.back().get()));
+        network.registerNode(nodes.back().get());
+    }
+
+    std::vector<Hash256> roots;
+    for (int height = 1; height <= 3; ++height) {
+        nodes[height - 1]->createTransaction(4, 10.0);
+        nodes[height - 1]->proposeBlock();
+        network.run(); // Returns once the executors are done too
+        roots.push_back(stateMachines[0]->getStateRoot());
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i]->getBlockchain().getChainLength(), 4);
+        EXPECT_DOUBLE_EQ(stateMachines[i]->getBalance(4), 1030.0);
+        EXPECT_EQ(stateMachines[i]->getStateRoot(), roots.back());
+    }
+    const Blockchain& chain = nodes[3]->getBlockchain();
+    EXPECT_EQ(chain.getBlock(2)->getAppHash(), Hash256()); // Nothing executed two heights before
+    EXPECT_EQ(chain.getBlock(3)->getAppHash(), roots[0]);  // State after block 1
+}
+
+// What a node that crashed at height 1 left behind: its accepted proposal and prevote, optionally the decision
+static std::string writeCrashedWal(const std::string& name, const Block& block, bool decided) {
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove(path);
+
+    WriteAheadLog wal(path);
+    auto payload = std::make_shared<std::string>();
+    ByteWriter(*payload).writeI32(-1); // Fresh block, no earlier polka
+    block.serialize(*payload);
+    wal.append(WalEntryType::PROPOSAL, Message(PROPOSAL, 1, 1, 0, block.getHash(), payload).encode());
+    wal.append(WalEntryType::VOTE, Message(PREVOTE, 1, 1, 0, block.getHash()).encode());
+    if (decided) {
+        std::string decision;
+        ByteWriter writer(decision);
+        writer.writeU64(1);
+        writer.writeBytes(block.getHash().data(), Hash256::SIZE);
+        wal.append(WalEntryType::COMMIT, decision);
+    }
+    wal.sync();
+    return path;
+}
+
+TEST(ConsensusTest, ConsensusRecoveryCommitsDecidedBlock) {
+    Network network;
+    StateMachine stateMachine;
+    Node node(1, &network, &stateMachine);
+    network.registerNode(&node);
+
+    Block block(1, node.getBlockchain().getLatestBlock().getHash(), {Transaction(1, 2, 100.0, 0)});
+    std::string path = writeCrashedWal("tendermint-wal-decided", block, true);
+
+    ASSERT_TRUE(node.recoverConsensus(path));
+    EXPECT_EQ(node.getBlockchain().getChainLength(), 2);
+    EXPECT_EQ(node.getBlockchain().getLatestBlock().getHash(), block.getHash());
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(1), 900.0);
+    EXPECT_EQ(std::filesystem::file_size(path), 0u); // Nothing undecided left to replay
+    std::filesystem::remove(path);
+}
+
+TEST(ConsensusTest, ConsensusRecoveryResumesUndecidedRound) {
+    Network network;
+    StateMachine stateMachine;
+    Node node(1, &network, &stateMachine);
+    network.registerNode(&node);
+
+    Block block(1, node.getBlockchain().getLatestBlock().getHash(), {Transaction(1, 2, 100.0, 0)});
+    std::string path = writeCrashedWal("tendermint-wal-undecided", block, false);
+
+    ASSERT_TRUE(node.recoverConsensus(path));
+    EXPECT_EQ(node.getBlockchain().getChainLength(), 1);
+    std::ostringstream status;
+    node.printStatus(status);
+    EXPECT_NE(status.str().find("Consensus stage: PREVOTE"), std::string::npos);
+
+    // The restarted leader must not sign a different block for the same height and round
+    node.createTransaction(3, 50.0);
+    node.proposeBlock();
+    network.run();
+    ASSERT_EQ(node.getBlockchain().getChainLength(), 3); // The new transaction waited for height 2
+    EXPECT_EQ(node.getBlockchain().getBlock(1)->getHash(), block.getHash());
+    std::filesystem::remove(path);
+}
+
+TEST(ConsensusTest, ConsensusMovesToNextRoundWhenProposerIsSilent) {
+    Network network;
+    Network isolated; // Node 1 sees no validators here, so it never proposes or votes
+    std::vector<std::unique_ptr<StateMachine>> stateMachines;
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (int id = 1; id <= 4; ++id) {
+        stateMachines.push_back(std::make_unique<StateMachine>());
+        nodes.push_back(std::make_unique<Node>(id, id == 1 ? &isolated : &network, stateMachines.back().get()));
+        network.registerNode(nodes.back().get());
+    }
+
+    nodes[1]->createTransaction(3, 10.0);
+    nodes[1]->proposeBlock(); // Node 1 should lead round 0 of height 1
+    network.run();
+
+    // Round 0 ends in nil votes after its timeouts, and node 2 leads round 1
+    EXPECT_GE(network.getCurrentTimeMs(), 2LL * Config::getTimeout());
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i]->getBlockchain().getChainLength(), 2);
+        EXPECT_DOUBLE_EQ(stateMachines[i]->getBalance(3), 1010.0);
+    }
+    EXPECT_EQ(nodes[0]->getBlockchain().getChainLength(), 1);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "Logger.h"
+#include "RingBuffer.h"
+#include "Serialization.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct CaptureSink : LogSink {
+    std::vector<LogRecord>* records;
+    explicit CaptureSink(std::vector<LogRecord>* records) : records(records) {}
+    void write(const LogRecord& record) override {
+        records->push_back(record);
+    }
+};
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+} // namespace
+
+TEST(LoggerTest, DisabledLevelsAreNeverFormatted) {
+    std::vector<LogRecord> records; // Only touched by the writer until flush() returns
+    Logger& logger = Logger::instance();
+    logger.flush();
+    logger.clearSinks();
+    logger.addSink(std::make_unique<CaptureSink>(&records));
+    LogLevel previous = Logger::getLevel();
+    Logger::setLevel(LogLevel::WARN);
+
+    int formatted = 0;
+    LOG_DEBUG("debug " + std::to_string(++formatted));
+    LOG_INFO("info " + std::to_string(++formatted));
+    LOG_WARN("warn " + std::to_string(++formatted));
+    logger.flush();
+    EXPECT_EQ(formatted, 1);
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].level, LogLevel::WARN);
+    EXPECT_EQ(records[0].message, "warn 1");
+
+    Logger::setLevel(previous);
+    logger.clearSinks();
+    logger.addSink(std::make_unique<TextLogSink>());
+}
+
+TEST(LoggerTest, RingKeepsEveryProducersOrder) {
+    RingBuffer<uint64_t> ring(1000);
+    EXPECT_EQ(ring.capacity(), 1024u);
+
+    const uint64_t producers = 4;
+    const uint64_t perProducer = 20000;
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p, perProducer] {
+            for (uint64_t i = 0; i < perProducer; ++i) {
+                while (!ring.push(p * perProducer + i)) {
+                    std::this_thread::yield(); // Full; the consumer frees slots
+                }
+            }
+        });
+    }
+
+    std::vector<uint64_t> next(producers, 0);
+    for (uint64_t received = 0; received < producers * perProducer;) {
+        std::optional<uint64_t> value = ring.pop();
+        if (!value) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint64_t producer = *value / perProducer;
+        EXPECT_EQ(*value % perProducer, next[producer]);
+        next[producer] = *value % perProducer + 1;
+        ++received;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(ring.pop());
+}
+
+TEST(LoggerTest, JsonAndBinarySinks) {
+    std::string jsonPath = (std::filesystem::temp_directory_path() / "logger_test.jsonl").string();
+    std::string binaryPath = (std::filesystem::temp_directory_path() / "logger_test.bin").string();
+    std::filesystem::remove(jsonPath);
+    std::filesystem::remove(binaryPath);
+
+    LogRecord record;
+    record.timestampUs = 42;
+    record.level = LogLevel::ERROR;
+    record.threadId = 7;
+    record.message = "quote \" and\nnewline";
+    {
+        JsonLogSink json(jsonPath);
+        json.write(record);
+        BinaryLogSink binary(binaryPath);
+        binary.write(record);
+    }
+
+    EXPECT_EQ(readFile(jsonPath), "{\"ts\":42,\"level\":\"ERROR\",\"thread\":7,\"msg\":\"quote \\\" and\\nnewline\"}\n");
+
+    std::string bytes = readFile(binaryPath);
+    ASSERT_EQ(bytes.size(), BinaryLogSink::RECORD_HEADER_SIZE + record.message.size());
+    ByteReader reader(bytes);
+    EXPECT_EQ(reader.readU64(), 42u);
+    EXPECT_EQ(reader.readU8(), static_cast<uint8_t>(LogLevel::ERROR));
+    EXPECT_EQ(reader.readU64(), 7u);
+    EXPECT_EQ(reader.readU32(), record.message.size());
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include "Mempool.h"
+
+TEST(MempoolTest, MempoolDeduplicatesByHash) {
+    Mempool mempool;
+
+    EXPECT_TRUE(mempool.addTransaction(Transaction(1, 2, 10.0, 0)));
+    EXPECT_FALSE(mempool.addTransaction(Transaction(1, 2, 10.0, 0)));
+    EXPECT_TRUE(mempool.addTransaction(Transaction(1, 2, 10.0, 1))); // Same transfer, next nonce
+    EXPECT_EQ(mempool.size(), 2u);
+}
+
+TEST(MempoolTest, MempoolReapsWithinBlockLimits) {
+    Mempool mempool;
+    for (uint64_t nonce = 0; nonce < 10; ++nonce) {
+        mempool.addTransaction(Transaction(1, 2, 1.0, nonce));
+    }
+
+    EXPECT_EQ(mempool.reapBatch(4, 1024).size(), 4u);
+    EXPECT_EQ(mempool.reapBatch(100, 3 * Transaction::ENCODED_SIZE).size(), 3u);
+    EXPECT_EQ(mempool.size(), 10u); // Reaping does not remove anything
+
+    std::vector<Transaction> batch = mempool.reapBatch(4, 1024);
+    mempool.removeCommitted(batch);
+    EXPECT_EQ(mempool.size(), 6u);
+    EXPECT_EQ(mempool.reapBatch(1, 1024).front().getNonce(), 4u); // FIFO continues after the committed batch
+}
+
+TEST(MempoolTest, MempoolFeeOrdering) {
+    Mempool mempool(100, MempoolOrdering::FEE);
+    mempool.addTransaction(Transaction(1, 2, 1.0, 0, 0.1));
+    mempool.addTransaction(Transaction(1, 2, 1.0, 1, 0.5));
+    mempool.addTransaction(Transaction(1, 2, 1.0, 2, 0.5));
+
+    std::vector<Transaction> batch = mempool.reapBatch(3, 1024);
+    EXPECT_EQ(batch[0].getNonce(), 1u);
+    EXPECT_EQ(batch[1].getNonce(), 2u);
+    EXPECT_EQ(batch[2].getNonce(), 0u);
+
+    mempool.setOrdering(MempoolOrdering::FIFO);
+    EXPECT_EQ(mempool.reapBatch(1, 1024).front().getNonce(), 0u);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "MerkleTree.h"
+#include "Block.h"
+
+static std::vector<Transaction> makeTransactions(size_t count) {
+    std::vector<Transaction> transactions;
+    for (size_t i = 0; i < count; ++i) {
+        transactions.emplace_back(static_cast<int>(i % 7) + 1, static_cast<int>(i % 5) + 1, 1.0 + i, i);
+    }
+    return transactions;
+}
+
+TEST(MerkleTreeTest, ProofsVerifyForEveryTransaction) {
+    std::vector<Transaction> transactions = makeTransactions(7); // Odd count exercises the carried-up node
+    Block block(1, Hash256(), transactions);
+
+    for (size_t i = 0; i < transactions.size(); ++i) {
+        MerkleProof proof = block.getMerkleProof(i);
+        EXPECT_TRUE(MerkleTree::verifyProof(transactions[i], proof, block.getMerkleRoot()));
+    }
+
+    MerkleProof proof = block.getMerkleProof(2);
+    EXPECT_FALSE(MerkleTree::verifyProof(transactions[3], proof, block.getMerkleRoot()));
+    proof.siblings.pop_back();
+    EXPECT_FALSE(MerkleTree::verifyProof(transactions[2], proof, block.getMerkleRoot()));
+    EXPECT_THROW(block.getMerkleProof(transactions.size()), std::out_of_range);
+}
+
+TEST(MerkleTreeTest, ParallelLeafHashingMatchesSequential) {
+    std::vector<Transaction> transactions = makeTransactions(MerkleTree::PARALLEL_LEAF_THRESHOLD + 3);
+    MerkleTree tree(transactions);
+
+    // Rebuild the root level by level on this thread
+    std::vector<Hash256> level;
+    for (const Transaction& tx : transactions) {
+        level.push_back(MerkleTree::hashLeaf(tx));
+    }
+    while (level.size() > 1) {
+        std::vector<Hash256> above;
+        for (size_t i = 0; i + 1 < level.size(); i += 2) {
+            above.push_back(MerkleTree::hashInner(level[i], level[i + 1]));
+        }
+        if (level.size() % 2 == 1) {
+            above.push_back(level.back());
+        }
+        level.swap(above);
+    }
+
+    EXPECT_EQ(tree.getRoot(), level.front());
+    size_t last = transactions.size() - 1;
+    EXPECT_TRUE(MerkleTree::verifyProof(transactions[last], tree.getProof(last), tree.getRoot()));
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "Message.h"
+#include "Block.h"
+#include "Utils.h"
+#include <memory>
+
+TEST(MessageTest, MessageEncodeDecodeRoundTrip) {
+    Block block(3, Utils::calculateHash("previous"), {Transaction(1, 2, 10.0, 7), Transaction(2, 3, 2.5, 1, 0.1)});
+    auto payload = std::make_shared<std::string>();
+    block.serialize(*payload);
+
+    Message original(PROPOSAL, 4, 3, 1, block.getHash(), payload);
+    auto wire = std::make_shared<const std::string>(original.encode());
+    EXPECT_EQ(wire->size(), original.getEncodedSize());
+
+    Message decoded = Message::decode(wire);
+    EXPECT_EQ(decoded.getType(), PROPOSAL);
+    EXPECT_EQ(decoded.getSenderId(), 4);
+    EXPECT_EQ(decoded.getHeight(), 3u);
+    EXPECT_EQ(decoded.getRound(), 1u);
+    EXPECT_EQ(decoded.getBlockHash(), block.getHash());
+
+    // The payload is a view into the received buffer, not a copy
+    EXPECT_GE(decoded.getPayload().data(), wire->data());
+    EXPECT_LT(decoded.getPayload().data(), wire->data() + wire->size());
+
+    Block received = Block::deserialize(decoded.getPayload());
+    EXPECT_EQ(received.getHash(), block.getHash());
+    EXPECT_EQ(received.getTransactions()[1].getFee(), 0.1);
+}
+
+TEST(MessageTest, MessageCopiesSharePayload) {
+    Message message(PREVOTE, 1, "shared payload");
+    Message copy = message;
+    EXPECT_EQ(copy.getPayload().data(), message.getPayload().data());
+
+    auto truncated = std::make_shared<const std::string>(message.encode().substr(0, 10));
+    EXPECT_THROW(Message::decode(truncated), std::runtime_error);
+}
+
+TEST(MessageTest, HashHexRoundTrip) {
+    Hash256 hash = Utils::calculateHash("abc");
+    EXPECT_EQ(hash.toHex(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(Hash256::fromHex(hash.toHex()), hash);
+    EXPECT_TRUE(Hash256().isZero());
+    EXPECT_THROW(Hash256::fromHex("abc"), std::invalid_argument);
+}
+
+TEST(MessageTest, SignatureCoversEveryField) {
+    Ed25519KeyPair key = Ed25519KeyPair::generate();
+    Message message(PRECOMMIT, 2, 5, 1, Utils::calculateHash("block"));
+    EXPECT_FALSE(message.isSigned());
+    message.setSignature(key.sign(message.getSignBytes()));
+
+    Message decoded = Message::decode(std::make_shared<const std::string>(message.encode()));
+    EXPECT_TRUE(decoded.isSigned());
+    EXPECT_TRUE(key.getPublicKey().verify(decoded.getSignBytes(), decoded.getSignature()));
+
+    Message otherRound(PRECOMMIT, 2, 5, 2, Utils::calculateHash("block"));
+    otherRound.setSignature(message.getSignature());
+    EXPECT_FALSE(key.getPublicKey().verify(otherRound.getSignBytes(), otherRound.getSignature()));
+
+    // Keys stored as seeds come back as the same key
+    Ed25519KeyPair restored = Ed25519KeyPair::fromSeed(key.getSeed());
+    EXPECT_EQ(restored.getPublicKey().getBytes(), key.getPublicKey().getBytes());
+}
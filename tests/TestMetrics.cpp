@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "Metrics.h"
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(MetricsTest, HistogramBucketsBoundTheError) {
+    for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        size_t index = Histogram::bucketIndex(value);
+        ASSERT_LT(index, Histogram::BUCKET_COUNT);
+        uint64_t upper = Histogram::bucketUpperBound(index);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / Histogram::SUB_BUCKETS); // Within 1/16 of the value
+        if (index > 0) {
+            EXPECT_LT(Histogram::bucketUpperBound(index - 1), value);
+        }
+    }
+
+    // Each thread records into its own shard; the snapshot sees all of them
+    Histogram histogram;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram] {
+            for (uint64_t value = 1; value <= 1000; ++value) {
+                histogram.record(value);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    HistogramSnapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 4000u);
+    EXPECT_EQ(snapshot.sum, 4u * 500500u);
+    EXPECT_EQ(snapshot.max, 1000u);
+    EXPECT_NEAR(static_cast<double>(snapshot.percentile(0.5)), 500.0, 500.0 / Histogram::SUB_BUCKETS);
+    EXPECT_EQ(snapshot.percentile(1.0), 1000u);
+}
+
+TEST(MetricsTest, PrometheusTextGroupsLabelledSeries) {
+    Metrics::counter("test_requests_total{kind=\"a\"}", "Requests").increment(3);
+    Metrics::counter("test_requests_total{kind=\"b\"}", "Requests").increment();
+    Metrics::gauge("test_queue_depth", "Queue depth").set(7);
+    Metrics::histogram("test_latency_us{stage=\"x\"}", "Latency").record(40);
+    EXPECT_THROW(Metrics::counter("test_queue_depth{kind=\"a\"}", "Queue depth"), std::logic_error);
+    EXPECT_EQ(&Metrics::gauge("test_queue_depth", "Queue depth"), &Metrics::gauge("test_queue_depth", "Ignored"));
+
+    std::ostringstream text;
+    Metrics::writePrometheus(text);
+    std::string out = text.str();
+    EXPECT_NE(out.find("# TYPE test_requests_total counter\ntest_requests_total{kind=\"a\"} 3\ntest_requests_total{kind=\"b\"} 1\n"), std::string::npos);
+    EXPECT_NE(out.find("test_queue_depth 7\n"), std::string::npos);
+    EXPECT_NE(out.find("# TYPE test_latency_us summary\n"), std::string::npos);
+    EXPECT_NE(out.find("test_latency_us{stage=\"x\",quantile=\"0.5\"} 40\n"), std::string::npos);
+    EXPECT_NE(out.find("test_latency_us_count{stage=\"x\"} 1\n"), std::string::npos);
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "Network.h"
 #include "Node.h"
+#include <chrono>
 
 TEST(NetworkTest, NetworkRegisterNode) {
     Network network;
@@ -23,4 +24,105 @@ TEST(NetworkTest, NetworkBroadcastMessage) {
 
     Message message(PROPOSAL, 1, "TestBroadcast");
     network.broadcastMessage(message);
+    EXPECT_EQ(network.getPendingDeliveries(), 1u); // Scheduled, not delivered inline
+
+    // Replies produced by the handlers are delivered by the same loop
+    EXPECT_GE(network.run(), 1u);
+    EXPECT_EQ(network.getPendingDeliveries(), 0u);
+}
+
+TEST(NetworkTest, NetworkDropRateApplies) {
+    Network network;
+    StateMachine stateMachine;
+
+    Node node1(1, &network, &stateMachine);
+    Node node2(2, &network, &stateMachine);
+    Node node3(3, &network, &stateMachine);
+    network.registerNode(&node1);
+    network.registerNode(&node2);
+    network.registerNode(&node3);
+
+    network.setMessageDropRate(1.0);
+    network.setMessageDropRate(1.5); // Out of range, ignored
+    network.broadcastMessage(Message(PROPOSAL, 1, "Lost"));
+    EXPECT_EQ(network.getPendingDeliveries(), 0u);
+
+    network.setMessageDropRate(0.0);
+    network.broadcastMessage(Message(PROPOSAL, 1, "Delivered"));
+    EXPECT_EQ(network.getPendingDeliveries(), 2u);
+    network.run();
+}
+
+TEST(NetworkTest, NetworkSimulatedClockSkipsDelays) {
+    Network network;
+    StateMachine stateMachine;
+
+    Node node1(1, &network, &stateMachine);
+    network.registerNode(&node1);
+
+    auto start = std::chrono::steady_clock::now();
+    network.scheduleTimeout(&node1, 60000, Message(TIMEOUT, 1, "Block_0"));
+    network.run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(network.getCurrentTimeMs(), 60000);
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 1000);
+}
+
+TEST(NetworkTest, NetworkThreadPerNodeDelivery) {
+    Network network;
+    StateMachine stateMachine;
+
+    Node node1(1, &network, &stateMachine);
+    Node node2(2, &network, &stateMachine);
+    Node node3(3, &network, &stateMachine);
+
+    network.registerNode(&node1);
+    network.registerNode(&node2);
+    network.registerNode(&node3);
+    network.setExecutionMode(ExecutionMode::THREAD_PER_NODE);
+    EXPECT_TRUE(node2.hasWorker());
+
+    network.broadcastMessage(Message(PROPOSAL, 1, "Block_1"));
+    EXPECT_GE(network.run(), 2u);
+    EXPECT_EQ(network.getPendingDeliveries(), 0u);
+
+    network.setExecutionMode(ExecutionMode::SINGLE_THREADED);
+    EXPECT_FALSE(node2.hasWorker());
+}
+
+TEST(NetworkTest, TimerWheelFiresInOrderAndCancels) {
+    TimerWheel<int> wheel(10, 8); // Small wheel so timers wrap around it
+    wheel.schedule(250, 3);
+    wheel.schedule(15, 1);
+    uint64_t cancelled = wheel.schedule(20, 99);
+    wheel.schedule(15, 2);
+    EXPECT_TRUE(wheel.cancel(cancelled));
+    EXPECT_FALSE(wheel.cancel(cancelled));
+    EXPECT_EQ(wheel.nextDueMs(), 15);
+
+    std::vector<int> expired;
+    wheel.popDue(100, expired);
+    EXPECT_EQ(expired, (std::vector<int>{1, 2}));
+    EXPECT_EQ(wheel.nextDueMs(), 250); // A revolution away, not in the slot it shares
+    wheel.popDue(249, expired);
+    EXPECT_EQ(expired.size(), 2u);
+    wheel.popDue(250, expired);
+    EXPECT_EQ(expired.back(), 3);
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(NetworkTest, CancelledTimeoutIsNeverDelivered) {
+    Network network;
+    StateMachine stateMachine;
+    Node node1(1, &network, &stateMachine);
+    network.registerNode(&node1);
+
+    uint64_t timer = network.scheduleTimeout(&node1, 5000, Message(TIMEOUT, 1, "Block_0"));
+    network.scheduleTimeout(&node1, 100, Message(TIMEOUT, 1, "Block_0"));
+    EXPECT_EQ(network.getPendingDeliveries(), 2u);
+    EXPECT_TRUE(network.cancelTimeout(timer));
+
+    EXPECT_EQ(network.run(), 1u);
+    EXPECT_EQ(network.getCurrentTimeMs(), 100); // The clock never advanced to the cancelled timer
 }
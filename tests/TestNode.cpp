@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "Node.h"
 #include "Network.h"
+#include <filesystem>
 
 TEST(NodeTest, NodeInitialization) {
     Network network;
@@ -19,3 +20,71 @@ TEST(NodeTest, NodeReceiveMessage) {
     Message message(PROPOSAL, 2, "TestProposal");
     node.receiveMessage(message);
 }
+
+TEST(NodeTest, NonceContinuesAfterRestart) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tendermint-node-nonce";
+    std::filesystem::remove_all(directory);
+    Transaction committed(0, 0, 0.0, 0);
+    {
+        Network network;
+        StateMachine stateMachine;
+        Node node(1, &network, &stateMachine);
+        ASSERT_TRUE(node.openStorage(directory.string()));
+        network.registerNode(&node);
+        node.createTransaction(2, 10.0);
+        committed = network.getMempool().getTransactions().at(0);
+        node.proposeBlock();
+        network.run();
+        ASSERT_EQ(node.getBlockchain().getChainLength(), 2);
+    }
+
+    Network network;
+    StateMachine stateMachine;
+    Node restarted(1, &network, &stateMachine);
+    ASSERT_TRUE(restarted.openStorage(directory.string()));
+    network.registerNode(&restarted);
+    restarted.createTransaction(2, 10.0); // Same transfer again
+    Transaction again = network.getMempool().getTransactions().at(0);
+    EXPECT_EQ(again.getNonce(), committed.getNonce() + 1);
+    EXPECT_NE(again.getHash(), committed.getHash());
+    EXPECT_FALSE(restarted.getBlockchain().findTransaction(again.getHash()).has_value());
+    std::filesystem::remove_all(directory);
+}
+
+TEST(NodeTest, ExecutingAnEmptyBlockReleasesSnapshots) {
+    Network network;
+    StateMachine stateMachine;
+    Node node(1, &network, &stateMachine);
+
+    for (int height = 1; height <= 3; ++height) {
+        stateMachine.createSnapshot(); // As the proposer of each height does
+        Block block(height, node.getBlockchain().getLatestBlock().getHash(), {});
+        ASSERT_TRUE(node.getExecutor().execute(block));
+    }
+    EXPECT_EQ(stateMachine.getSnapshotCount(), 0u);
+}
+
+TEST(NodeTest, TruncatedKeyFileIsReplacedAndKept) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tendermint-node-key";
+    std::filesystem::remove_all(directory);
+    Network network;
+    StateMachine stateMachine;
+    {
+        Node node(1, &network, &stateMachine);
+        ASSERT_TRUE(node.openStorage(directory.string()));
+    }
+    std::filesystem::resize_file(directory / "node.key", 10);
+
+    std::array<uint8_t, Ed25519PublicKey::SIZE> replaced;
+    {
+        Node node(1, &network, &stateMachine);
+        ASSERT_TRUE(node.openStorage(directory.string()));
+        replaced = node.getPublicKey().getBytes();
+    }
+    EXPECT_EQ(std::filesystem::file_size(directory / "node.key"), Ed25519KeyPair::SEED_SIZE);
+
+    Node restarted(1, &network, &stateMachine);
+    ASSERT_TRUE(restarted.openStorage(directory.string()));
+    EXPECT_EQ(restarted.getPublicKey().getBytes(), replaced);
+    std::filesystem::remove_all(directory);
+}
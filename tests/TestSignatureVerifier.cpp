@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "SignatureVerifier.h"
+#include "Network.h"
+#include "Utils.h"
+#include <vector>
+
+TEST(SignatureVerifierTest, BatchRejectsForgeriesAndCachesCopies) {
+    Network network;
+    std::vector<Ed25519KeyPair> keys;
+    for (int id = 1; id <= 12; ++id) {
+        keys.push_back(Ed25519KeyPair::generate());
+        network.setPublicKey(id, keys.back().getPublicKey());
+    }
+
+    Hash256 block = Utils::calculateHash("block");
+    std::vector<Message> batch;
+    for (int id = 1; id <= 12; ++id) {
+        Message vote(PREVOTE, id, 1, 0, block);
+        vote.setSignature(keys[id - 1].sign(vote.getSignBytes()));
+        batch.push_back(vote);
+    }
+    batch[3].setSignature(batch[4].getSignature()); // Node 4 forged with node 5's signature
+    batch.push_back(Message(PREVOTE, 13, 1, 0, block)); // Unsigned
+    batch.push_back(Message(TIMEOUT, 99, 1, 0, Hash256())); // Not our timer
+
+    SignatureVerifier verifier(&network, 1);
+    std::vector<VerifyResult> results = verifier.verifyBatch(batch);
+    for (size_t i = 0; i < 12; ++i) {
+        EXPECT_EQ(results[i], i == 3 ? VerifyResult::INVALID : VerifyResult::VALID);
+    }
+    EXPECT_EQ(results[12], VerifyResult::INVALID);
+    EXPECT_EQ(results[13], VerifyResult::INVALID);
+    EXPECT_EQ(verifier.getSignatureChecks(), 12u);
+
+    // Re-sent copies hit the cache; a second signed block for the same slot is equivocation
+    Message equivocation(PREVOTE, 2, 1, 0, Utils::calculateHash("other block"));
+    equivocation.setSignature(keys[1].sign(equivocation.getSignBytes()));
+    results = verifier.verifyBatch({batch[0], batch[1], equivocation});
+    EXPECT_EQ(results, (std::vector<VerifyResult>{VerifyResult::VALID, VerifyResult::VALID, VerifyResult::CONFLICTING}));
+    EXPECT_EQ(verifier.getSignatureChecks(), 13u);
+
+    // A cached signature replayed with other signed fields (here the payload) is checked again and fails
+    Message proposal(PROPOSAL, 2, 1, 0, block, std::make_shared<const std::string>("valid round 0"));
+    proposal.setSignature(keys[1].sign(proposal.getSignBytes()));
+    Message altered(PROPOSAL, 2, 1, 0, block, std::make_shared<const std::string>("valid round 5"));
+    altered.setSignature(proposal.getSignature());
+    EXPECT_EQ(verifier.verifyBatch({proposal}).front(), VerifyResult::VALID);
+    EXPECT_EQ(verifier.verifyBatch({altered}).front(), VerifyResult::INVALID);
+    EXPECT_EQ(verifier.getSignatureChecks(), 15u);
+
+    verifier.pruneBelow(2);
+    EXPECT_EQ(verifier.getCacheSize(), 0u);
+
+    // Decided heights are skipped, never reported as valid
+    Message forged(PREVOTE, 3, 1, 0, block);
+    forged.setSignature(batch[4].getSignature());
+    results = verifier.verifyBatch({batch[0], forged, Message(PREVOTE, 13, 1, 0, block)});
+    EXPECT_EQ(results, (std::vector<VerifyResult>(3, VerifyResult::STALE)));
+    EXPECT_EQ(verifier.getSignatureChecks(), 15u);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "StateMachine.h"
+#include "SnapshotStore.h"
+#include <filesystem>
+#include <fstream>
+
+TEST(StateMachineTest, PrepareCommitOnlyTouchesPendingAccounts) {
+    StateMachine stateMachine;
+    stateMachine.prepareState({Transaction(1, 2, 100.0), Transaction(2, 5, 50.0)});
+    EXPECT_FALSE(stateMachine.isCommitSuccessful());
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(1), 1000.0); // Not visible before commit
+
+    stateMachine.commitState();
+    EXPECT_TRUE(stateMachine.isCommitSuccessful());
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(1), 900.0);
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(2), 1050.0);
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(3), 1000.0);
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(5), 50.0);
+}
+
+TEST(StateMachineTest, RollbackUndoesWritesSinceSnapshot) {
+    StateMachine stateMachine;
+    stateMachine.createSnapshot();
+    stateMachine.applyTransactions({Transaction(1, 2, 100.0)});
+
+    stateMachine.createSnapshot();
+    stateMachine.prepareState({Transaction(2, 6, 300.0)});
+    stateMachine.commitState();
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(6), 300.0);
+
+    stateMachine.rollbackState();
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(2), 1100.0);
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(6), 0.0);
+
+    stateMachine.rollbackState();
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(1), 1000.0);
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(2), 1000.0);
+}
+
+TEST(StateMachineTest, StateRootFollowsCommitsAndRollbacks) {
+    StateMachine stateMachine;
+    Hash256 genesis = stateMachine.getStateRoot();
+
+    stateMachine.createSnapshot();
+    stateMachine.prepareState({Transaction(1, 6, 300.0), Transaction(2, 3, 5.0)});
+    stateMachine.commitState();
+    Hash256 committed = stateMachine.getStateRoot();
+    EXPECT_NE(committed, genesis);
+
+    // Same accounts reached in another order, through other slots
+    StateMachine reordered;
+    reordered.applyTransactions({Transaction(2, 3, 5.0), Transaction(1, 6, 300.0)});
+    EXPECT_EQ(reordered.getStateRoot(), committed);
+
+    stateMachine.rollbackState(); // Also removes account 6 again
+    EXPECT_EQ(stateMachine.getStateRoot(), genesis);
+}
+
+TEST(StateMachineTest, SparseIdsAndFixedPointAmounts) {
+    StateMachine stateMachine;
+    stateMachine.prepareState({Transaction(1, -7, 0.1), Transaction(1, 1 << 20, 0.2), Transaction(-7, 1 << 20, 0.1, 4)});
+    stateMachine.commitState();
+
+    EXPECT_EQ(stateMachine.getBalance(1), 999.7); // Exact in micro-units, no drift from repeated doubles
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(-7), 0.0);
+    EXPECT_DOUBLE_EQ(stateMachine.getBalance(1 << 20), 0.3);
+    EXPECT_EQ(stateMachine.getNonce(-7), 5u);
+}
+
+TEST(StateMachineTest, ParallelPrepareMatchesSequentialOrder) {
+    // Mostly disjoint transfers plus a hot account that forces conflicts and an overdraft partway through
+    std::vector<Transaction> transactions;
+    for (size_t i = 0; i < 2 * StateMachine::PARALLEL_EXECUTION_THRESHOLD; ++i) {
+        int id = 100 + static_cast<int>(i);
+        transactions.emplace_back(i % 3 == 0 ? 1 : 2, id, 0.2, i);
+        transactions.emplace_back(id, 3, 0.1, 0);
+    }
+    transactions.emplace(transactions.begin() + 3000, 4, 5, 5000.0, 9); // Node 4 only has 1000
+
+    StateMachine parallel;
+    parallel.prepareState(transactions);
+    parallel.commitState();
+
+    StateMachine sequential;
+    sequential.applyTransactions(std::vector<Transaction>(transactions.begin(), transactions.begin() + 3000));
+
+    for (int id : {1, 2, 3, 4, 5, 100, 1598, 1599, 1600, 4000}) {
+        EXPECT_DOUBLE_EQ(parallel.getBalance(id), sequential.getBalance(id)) << "account " << id;
+        EXPECT_EQ(parallel.getNonce(id), sequential.getNonce(id)) << "account " << id;
+    }
+}
+
+TEST(StateMachineTest, SnapshotRoundTripKeepsStateRoot) {
+    StateMachine original;
+    original.applyTransactions({Transaction(1, 2, 12.5, 0), Transaction(3, -9, 0.25, 7)});
+    std::string bytes;
+    original.encodeSnapshot(bytes, 42);
+
+    StateMachine restored;
+    restored.applyTransactions({Transaction(4, 1, 1.0, 0)}); // Overwritten by the snapshot
+    EXPECT_EQ(restored.restoreSnapshot(bytes), 42u);
+    EXPECT_EQ(restored.getStateRoot(), original.getStateRoot());
+    EXPECT_DOUBLE_EQ(restored.getBalance(4), 1000.0);
+    EXPECT_DOUBLE_EQ(restored.getBalance(-9), 0.25);
+    EXPECT_EQ(restored.getNonce(3), 8u);
+
+    bytes[bytes.size() - 1] ^= 0x01;
+    EXPECT_THROW(restored.restoreSnapshot(bytes), std::runtime_error);
+}
+
+TEST(StateMachineTest, SnapshotStoreLoadsNewestUsableSnapshot) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tendermint-snapshots";
+    std::filesystem::remove_all(directory);
+    SnapshotStore store(directory.string(), 2);
+
+    StateMachine stateMachine;
+    for (uint64_t height = 100; height <= 400; height += 100) {
+        stateMachine.applyTransactions({Transaction(1, 2, 1.0, height)});
+        store.save(stateMachine, height);
+    }
+    EXPECT_EQ(store.getHeights(), (std::vector<uint64_t>{300, 400}));
+
+    StateMachine restored;
+    EXPECT_EQ(store.loadLatest(restored, 350), 300u); // The chain only reached 350
+    EXPECT_DOUBLE_EQ(restored.getBalance(1), 997.0);
+
+    std::ofstream(directory / "state-000000000400.snap", std::ios::binary | std::ios::trunc) << "garbage";
+    EXPECT_EQ(store.loadLatest(restored, 1000), 300u);
+    EXPECT_EQ(store.loadLatest(restored, 99), 0u);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(StateMachineTest, SnapshotStoreKeepsStateWhenHeightDisagrees) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tendermint-snapshots-mislabelled";
+    std::filesystem::remove_all(directory);
+    SnapshotStore store(directory.string(), 2);
+
+    StateMachine stateMachine;
+    stateMachine.applyTransactions({Transaction(1, 2, 1.0, 1)});
+    store.save(stateMachine, 100);
+    std::filesystem::rename(directory / "state-000000000100.snap", directory / "state-000000000200.snap");
+
+    StateMachine restored;
+    restored.applyTransactions({Transaction(3, 4, 2.0, 1)});
+    Hash256 root = restored.getStateRoot();
+    EXPECT_EQ(store.loadLatest(restored, 1000), 0u);
+    EXPECT_EQ(restored.getStateRoot(), root);
+    EXPECT_DOUBLE_EQ(restored.getBalance(4), 1002.0);
+    std::filesystem::remove_all(directory);
+}
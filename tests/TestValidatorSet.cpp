@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include "ValidatorSet.h"
+#include "Network.h"
+#include "Config.h"
+#include <map>
+#include <vector>
+
+static std::vector<int> nextProposers(ValidatorSet set, int count) {
+    std::vector<int> proposers;
+    for (int i = 0; i < count; ++i) {
+        set.incrementProposerPriority(1);
+        proposers.push_back(set.getProposer()->id);
+    }
+    return proposers;
+}
+
+TEST(ValidatorSetTest, ProposersFollowVotingPower) {
+    ValidatorSet equal;
+    equal.update({{1, 1}, {2, 1}, {3, 1}, {4, 1}});
+    EXPECT_EQ(nextProposers(equal, 6), (std::vector<int>{1, 2, 3, 4, 1, 2}));
+    EXPECT_EQ(equal.getQuorumPower(), 3u);
+
+    ValidatorSet weighted;
+    weighted.update({{1, 3}, {2, 1}, {3, 1}});
+    std::map<int, int> turns;
+    for (int id : nextProposers(weighted, 500)) {
+        turns[id]++;
+    }
+    EXPECT_EQ(turns[1], 300);
+    EXPECT_EQ(turns[2], 100);
+    EXPECT_EQ(turns[3], 100);
+    EXPECT_EQ(weighted.getQuorumPower(), 4u); // More than two thirds of 5
+}
+
+TEST(ValidatorSetTest, JoinAndLeaveKeepIndexesConsistent) {
+    ValidatorSet set;
+    set.update({{1, 1}, {2, 1}, {3, 1}});
+    set.incrementProposerPriority(3);
+
+    set.update(4, 2); // Newcomer starts behind the others
+    for (const Validator& validator : set.getValidators()) {
+        if (validator.id != 4) {
+            EXPECT_GT(validator.proposerPriority, set.getValidator(set.getIndex(4)).proposerPriority);
+        }
+    }
+    EXPECT_EQ(set.getTotalPower(), 5u);
+
+    set.update(1, 0); // Last validator takes the leaver's index
+    EXPECT_FALSE(set.contains(1));
+    EXPECT_EQ(set.size(), 3u);
+    for (size_t i = 0; i < set.size(); ++i) {
+        EXPECT_EQ(set.getIndex(set.getValidator(i).id), i);
+    }
+    EXPECT_EQ(set.getIndex(1), ValidatorSet::NO_INDEX);
+    EXPECT_EQ(set.getTotalPower(), 4u);
+    EXPECT_THROW(set.update(2, ValidatorSet::MAX_TOTAL_VOTING_POWER), std::invalid_argument);
+    EXPECT_EQ(set.getTotalPower(), 4u);
+}
+
+TEST(ValidatorSetTest, NetworkAppliesPowerChangesFromTheNextHeight) {
+    Network network;
+    network.setVotingPower(1, 1);
+    network.setVotingPower(2, 1);
+    ValidatorSet first = network.getValidatorSet(1);
+    EXPECT_EQ(first.getTotalPower(), 2u);
+
+    network.setVotingPower(3, 4);
+    EXPECT_EQ(network.getValidatorSet(1).getTotalPower(), 2u); // Height 1 is already fixed
+    EXPECT_EQ(network.getValidatorSet(2).getTotalPower(), 6u);
+    EXPECT_EQ(network.getValidatorSet(2).getProposer()->id, network.getValidatorSet(2).getProposer()->id);
+
+    // Once a height drops out of the history no set stands in for it
+    uint64_t later = Config::getValidatorHistory() + 10;
+    EXPECT_EQ(network.getValidatorSet(later).getTotalPower(), 6u);
+    EXPECT_TRUE(network.getValidatorSet(1).empty());
+}
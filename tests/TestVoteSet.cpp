@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include "VoteSet.h"
+#include "Hash256.h"
+#include <string>
+
+TEST(VoteSetTest, QuorumPerBlockHashAndNil) {
+    Hash256 block = Hash256::fromHex(std::string(64, 'a'));
+    Hash256 nil;
+    VoteSet votes(1, 0, PREVOTE, 4, 3);
+
+    EXPECT_TRUE(votes.addVote(0, block));
+    EXPECT_TRUE(votes.addVote(1, block));
+    EXPECT_TRUE(votes.addVote(2, nil));
+    EXPECT_FALSE(votes.addVote(2, block)); // Equivocation, the first vote stands
+    EXPECT_FALSE(votes.addVote(7, block)); // Not a validator
+
+    EXPECT_TRUE(votes.hasQuorumAny());
+    EXPECT_FALSE(votes.hasQuorum(block));
+    EXPECT_FALSE(votes.getMajority().has_value());
+    EXPECT_EQ(votes.getPower(block), 2u);
+    EXPECT_EQ(votes.getPower(nil), 1u);
+
+    EXPECT_TRUE(votes.addVote(3, block));
+    EXPECT_TRUE(votes.hasQuorum(block));
+    EXPECT_EQ(*votes.getMajority(), block);
+    EXPECT_EQ(votes.getVoters().count(), 4u);
+
+    votes.reset(1, 1, PREVOTE, 4, 3);
+    EXPECT_FALSE(votes.hasVoted(0));
+    EXPECT_EQ(votes.getTotalPower(), 0u);
+    EXPECT_EQ(votes.getRound(), 1u);
+}
+
+TEST(VoteSetTest, BitArrayAcrossWords) {
+    BitArray bits(130);
+    EXPECT_TRUE(bits.set(0));
+    EXPECT_TRUE(bits.set(64));
+    EXPECT_TRUE(bits.set(129));
+    EXPECT_FALSE(bits.set(64));
+    EXPECT_FALSE(bits.set(130));
+    EXPECT_TRUE(bits.get(129));
+    EXPECT_FALSE(bits.get(128));
+    EXPECT_EQ(bits.count(), 3u);
+}
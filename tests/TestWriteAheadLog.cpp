@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "WriteAheadLog.h"
+#include "Utils.h"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+TEST(WriteAheadLogTest, GroupCommitAndReopen) {
+    std::string path = (fs::temp_directory_path() / "tendermint-wal-group").string();
+    fs::remove(path);
+    {
+        WriteAheadLog wal(path, FsyncPolicy::EVERY_BLOCK);
+        wal.append(WalEntryType::PROPOSAL, "proposal");
+        wal.append(WalEntryType::VOTE, "prevote");
+        wal.append(WalEntryType::VOTE, "precommit");
+        wal.sync();
+        wal.sync(); // Nothing buffered, no flush
+        EXPECT_EQ(wal.getSyncCount(), 1u);
+        wal.append(WalEntryType::COMMIT, "decision"); // Written by the destructor
+    }
+
+    WriteAheadLog reopened(path);
+    const std::vector<WalEntry>& entries = reopened.getRecoveredEntries();
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[0].type, WalEntryType::PROPOSAL);
+    EXPECT_EQ(entries[2].data, "precommit");
+    EXPECT_EQ(entries[3].type, WalEntryType::COMMIT);
+    fs::remove(path);
+}
+
+TEST(WriteAheadLogTest, TornTailIsDroppedAndResetEmpties) {
+    std::string path = (fs::temp_directory_path() / "tendermint-wal-torn").string();
+    fs::remove(path);
+    {
+        WriteAheadLog wal(path);
+        wal.append(WalEntryType::PROPOSAL, "proposal");
+        wal.append(WalEntryType::VOTE, "prevote");
+        wal.sync();
+    }
+    fs::resize_file(path, fs::file_size(path) - 3);
+    {
+        WriteAheadLog wal(path);
+        ASSERT_EQ(wal.getRecoveredEntries().size(), 1u);
+        wal.append(WalEntryType::VOTE, "prevote again");
+        wal.sync();
+    }
+    {
+        WriteAheadLog wal(path);
+        ASSERT_EQ(wal.getRecoveredEntries().size(), 2u);
+        EXPECT_EQ(wal.getRecoveredEntries()[1].data, "prevote again");
+        wal.reset();
+    }
+    EXPECT_TRUE(WriteAheadLog(path).getRecoveredEntries().empty());
+    fs::remove(path);
+}
+
+#ifndef _WIN32
+TEST(WriteAheadLogTest, SyncFileReportsAFailedFlush) {
+    std::FILE* file = std::fopen("/dev/full", "wb"); // Every write fails with ENOSPC
+    ASSERT_NE(file, nullptr);
+    std::fputs("record", file);
+    EXPECT_FALSE(Utils::syncFile(file));
+    std::fclose(file);
+}
+#endif